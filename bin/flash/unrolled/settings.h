@@ -0,0 +1,1087 @@
+// Generated on 19Oct26 10:03.
+
+#pragma once
+
+
+#ifdef Arduino_h
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#define JSON_BUF_SIZE 3000
+
+#define OUT(f)\
+    File settingsFile = SPIFFS.open(f, "w");\
+    root.prettyPrintTo(settingsFile);\
+    settingsFile.close();
+    
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "ArduinoJson-v5.13.4.h"
+
+#define String string
+#define JSON_BUF_SIZE 3000
+
+#define OUT(f)\
+    string buf;\
+    root.prettyPrintTo(buf);\
+    ofstream settingsFile(f);\
+    settingsFile << buf;\
+    settingsFile.close();
+#endif
+
+#define IN(f)\
+    JSONTEXT settingsFile;\
+    settingsFile.json = (char *)loadBytes(String(f).c_str(), settingsFile.length);
+
+#define READ_OK 0
+#define READ_PARSE_FAIL 1
+#define READ_VERSION_NO_MATCH 2
+#define READ_FILE_NOT_FOUND 3
+
+using namespace std;
+
+struct SETTINGS{
+  static constexpr char version[] = "1.2";
+  static constexpr char filename[] = "/settings.json";
+  double testDouble = 123.45;
+  long testStringDouble = 123456;
+  struct DEVICE {
+    String name = "GasMonitor";
+    String lastError = "none";
+    bool serialDiagnostics = true;
+    bool fileDiagnostics = false;
+    String diagnosticsFilename = "/gasDiag";
+    bool fileLog = false;
+    String logFilename = "/gasLog";
+    bool reset = false;
+    struct WIFI {
+      uint32_t currentIpAddress = 0x00000000u;
+      bool useMdns = true;
+      String mdnsGatewayAddress = "router.local";
+      struct ACCESSPOINTMODE {
+        char ssid[33] = "GasMonitor";
+        char password[64] = "inspector";
+        uint32_t ipAddress = 0x0104A8C0u;
+        uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+          h = fingerprintOf(h, this->ssid);
+          h = fingerprintOf(h, this->password);
+          h = fingerprintOf(h, this->ipAddress);
+          return h;
+        }
+        bool operator==(const ACCESSPOINTMODE &o) const{ //the persisted fields are equal
+          return !strcmp(this->ssid, o.ssid) && !strcmp(this->password, o.password) && this->ipAddress == o.ipAddress;
+        }
+        bool operator!=(const ACCESSPOINTMODE &o) const{ return !(*this == o); }
+      }accessPointMode;
+      struct STATIONMODE {
+        char ssid[33] = "MY_SSID";
+        char key[64] = "MY_KEY";
+        bool useDhcp = true;
+        uint32_t staticIpAddress = 0x5801A8C0u;
+        uint32_t gatewayAddress = 0xFF01A8C0u;
+        long connectToApTimeoutMs = 120000;
+        uint8_t connectToApAttempts = 5;
+        uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+          h = fingerprintOf(h, this->ssid);
+          h = fingerprintOf(h, this->key);
+          h = fingerprintOf(h, this->useDhcp);
+          h = fingerprintOf(h, this->staticIpAddress);
+          h = fingerprintOf(h, this->gatewayAddress);
+          h = fingerprintOf(h, this->connectToApTimeoutMs);
+          h = fingerprintOf(h, this->connectToApAttempts);
+          return h;
+        }
+        bool operator==(const STATIONMODE &o) const{ //the persisted fields are equal
+          return !strcmp(this->ssid, o.ssid) && !strcmp(this->key, o.key) && this->useDhcp == o.useDhcp && this->staticIpAddress == o.staticIpAddress && this->gatewayAddress == o.gatewayAddress && this->connectToApTimeoutMs == o.connectToApTimeoutMs && this->connectToApAttempts == o.connectToApAttempts;
+        }
+        bool operator!=(const STATIONMODE &o) const{ return !(*this == o); }
+      }stationMode;
+      uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+        h = fingerprintOf(h, this->useMdns);
+        h = fingerprintOf(h, this->mdnsGatewayAddress);
+        h = this->accessPointMode.fingerprint(h);
+        h = this->stationMode.fingerprint(h);
+        return h;
+      }
+      bool operator==(const WIFI &o) const{ //the persisted fields are equal
+        return this->useMdns == o.useMdns && this->mdnsGatewayAddress == o.mdnsGatewayAddress && this->accessPointMode == o.accessPointMode && this->stationMode == o.stationMode;
+      }
+      bool operator!=(const WIFI &o) const{ return !(*this == o); }
+    }wiFi;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = fingerprintOf(h, this->name);
+      h = fingerprintOf(h, this->serialDiagnostics);
+      h = fingerprintOf(h, this->fileDiagnostics);
+      h = fingerprintOf(h, this->diagnosticsFilename);
+      h = fingerprintOf(h, this->fileLog);
+      h = fingerprintOf(h, this->logFilename);
+      h = fingerprintOf(h, this->reset);
+      h = this->wiFi.fingerprint(h);
+      return h;
+    }
+    bool operator==(const DEVICE &o) const{ //the persisted fields are equal
+      return this->name == o.name && this->serialDiagnostics == o.serialDiagnostics && this->fileDiagnostics == o.fileDiagnostics && this->diagnosticsFilename == o.diagnosticsFilename && this->fileLog == o.fileLog && this->logFilename == o.logFilename && this->reset == o.reset && this->wiFi == o.wiFi;
+    }
+    bool operator!=(const DEVICE &o) const{ return !(*this == o); }
+  }device;
+  struct LOCALSERVERS {
+    struct HTTP {
+      uint16_t port = 80;
+      String indexForm = "/index.html";
+      String settingsForm = "/settings.html";
+      static constexpr char valuesJs[] = "/valuesJs.js";
+      uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+        h = fingerprintOf(h, this->port);
+        h = fingerprintOf(h, this->indexForm);
+        h = fingerprintOf(h, this->settingsForm);
+        return h;
+      }
+      bool operator==(const HTTP &o) const{ //the persisted fields are equal
+        return this->port == o.port && this->indexForm == o.indexForm && this->settingsForm == o.settingsForm;
+      }
+      bool operator!=(const HTTP &o) const{ return !(*this == o); }
+    }http;
+    struct MQTT {
+      uint16_t port = 1883;
+      uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+        h = fingerprintOf(h, this->port);
+        return h;
+      }
+      bool operator==(const MQTT &o) const{ //the persisted fields are equal
+        return this->port == o.port;
+      }
+      bool operator!=(const MQTT &o) const{ return !(*this == o); }
+    }mqtt;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = this->http.fingerprint(h);
+      h = this->mqtt.fingerprint(h);
+      return h;
+    }
+    bool operator==(const LOCALSERVERS &o) const{ //the persisted fields are equal
+      return this->http == o.http && this->mqtt == o.mqtt;
+    }
+    bool operator!=(const LOCALSERVERS &o) const{ return !(*this == o); }
+  }localServers;
+  struct REMOTESERVERS {
+    struct MQTT {
+      String brokerAddress = "homeautomation.local";
+      uint16_t brokerPort = 1883;
+      uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+        h = fingerprintOf(h, this->brokerAddress);
+        h = fingerprintOf(h, this->brokerPort);
+        return h;
+      }
+      bool operator==(const MQTT &o) const{ //the persisted fields are equal
+        return this->brokerAddress == o.brokerAddress && this->brokerPort == o.brokerPort;
+      }
+      bool operator!=(const MQTT &o) const{ return !(*this == o); }
+    }mqtt;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = this->mqtt.fingerprint(h);
+      return h;
+    }
+    bool operator==(const REMOTESERVERS &o) const{ //the persisted fields are equal
+      return this->mqtt == o.mqtt;
+    }
+    bool operator!=(const REMOTESERVERS &o) const{ return !(*this == o); }
+  }remoteServers;
+  struct GAS {
+    long publishDataPeriodMs = 60000;
+    long lastHeardFromPeriodS = 600;
+    struct DIAGNOSTICS {
+      long rev = 89321;
+      long errors = 22;
+      struct EXTRA {
+        long bounce1 = 225;
+        long bounce2 = 1;
+        struct CONTROL {
+          bool reset = false;
+          uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+            h = fingerprintOf(h, this->reset);
+            return h;
+          }
+          bool operator==(const CONTROL &o) const{ //the persisted fields are equal
+            return this->reset == o.reset;
+          }
+          bool operator!=(const CONTROL &o) const{ return !(*this == o); }
+        }control;
+        uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+          h = fingerprintOf(h, this->bounce1);
+          h = fingerprintOf(h, this->bounce2);
+          h = this->control.fingerprint(h);
+          return h;
+        }
+        bool operator==(const EXTRA &o) const{ //the persisted fields are equal
+          return this->bounce1 == o.bounce1 && this->bounce2 == o.bounce2 && this->control == o.control;
+        }
+        bool operator!=(const EXTRA &o) const{ return !(*this == o); }
+      }extra;
+      uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+        h = fingerprintOf(h, this->rev);
+        h = this->extra.fingerprint(h);
+        return h;
+      }
+      bool operator==(const DIAGNOSTICS &o) const{ //the persisted fields are equal
+        return this->rev == o.rev && this->extra == o.extra;
+      }
+      bool operator!=(const DIAGNOSTICS &o) const{ return !(*this == o); }
+    }diagnostics;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = fingerprintOf(h, this->publishDataPeriodMs);
+      h = fingerprintOf(h, this->lastHeardFromPeriodS);
+      h = this->diagnostics.fingerprint(h);
+      return h;
+    }
+    bool operator==(const GAS &o) const{ //the persisted fields are equal
+      return this->publishDataPeriodMs == o.publishDataPeriodMs && this->lastHeardFromPeriodS == o.lastHeardFromPeriodS && this->diagnostics == o.diagnostics;
+    }
+    bool operator!=(const GAS &o) const{ return !(*this == o); }
+  }gas;
+  struct WEATHER {
+    long publishDataPeriodMs = 30000;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = fingerprintOf(h, this->publishDataPeriodMs);
+      return h;
+    }
+    bool operator==(const WEATHER &o) const{ //the persisted fields are equal
+      return this->publishDataPeriodMs == o.publishDataPeriodMs;
+    }
+    bool operator!=(const WEATHER &o) const{ return !(*this == o); }
+  }weather;
+
+  bool writeSettingsFile() {
+    if (!this->loadLazy()) return false; //everything is about to be written, not the defaults of what couldn't be loaded
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    JsonObject &root = jb.createObject();
+    root["version"] = this->version;
+    root["testDouble"] = this->testDouble;
+    root["testStringDouble"] = RawJson(formatDecimal(this->testStringDouble, 3));
+    root.createNestedObject("device");
+    root["device"]["name"] = this->device.name;
+    root["device"]["serialDiagnostics"] = this->device.serialDiagnostics;
+    root["device"]["fileDiagnostics"] = this->device.fileDiagnostics;
+    root["device"]["diagnosticsFilename"] = this->device.diagnosticsFilename;
+    root["device"]["fileLog"] = this->device.fileLog;
+    root["device"]["logFilename"] = this->device.logFilename;
+    root["device"]["reset"] = this->device.reset;
+    root["device"].as<JsonObject>().createNestedObject("wiFi");
+    root["device"]["wiFi"]["useMdns"] = this->device.wiFi.useMdns;
+    root["device"]["wiFi"]["mdnsGatewayAddress"] = this->device.wiFi.mdnsGatewayAddress;
+    root["device"]["wiFi"].as<JsonObject>().createNestedObject("accessPointMode");
+    root["device"]["wiFi"]["accessPointMode"]["ssid"] = this->device.wiFi.accessPointMode.ssid;
+    root["device"]["wiFi"]["accessPointMode"]["password"] = this->device.wiFi.accessPointMode.password;
+    root["device"]["wiFi"]["accessPointMode"]["ipAddress"] = formatIpv4(this->device.wiFi.accessPointMode.ipAddress);
+    root["device"]["wiFi"].as<JsonObject>().createNestedObject("stationMode");
+    root["device"]["wiFi"]["stationMode"]["ssid"] = this->device.wiFi.stationMode.ssid;
+    root["device"]["wiFi"]["stationMode"]["key"] = this->device.wiFi.stationMode.key;
+    root["device"]["wiFi"]["stationMode"]["useDhcp"] = this->device.wiFi.stationMode.useDhcp;
+    root["device"]["wiFi"]["stationMode"]["staticIpAddress"] = formatIpv4(this->device.wiFi.stationMode.staticIpAddress);
+    root["device"]["wiFi"]["stationMode"]["gatewayAddress"] = formatIpv4(this->device.wiFi.stationMode.gatewayAddress);
+    root["device"]["wiFi"]["stationMode"]["connectToApTimeoutMs"] = this->device.wiFi.stationMode.connectToApTimeoutMs;
+    root["device"]["wiFi"]["stationMode"]["connectToApAttempts"] = this->device.wiFi.stationMode.connectToApAttempts;
+    root.createNestedObject("localServers");
+    root["localServers"].as<JsonObject>().createNestedObject("http");
+    root["localServers"]["http"]["port"] = this->localServers.http.port;
+    root["localServers"]["http"]["indexForm"] = this->localServers.http.indexForm;
+    root["localServers"]["http"]["settingsForm"] = this->localServers.http.settingsForm;
+    root["localServers"].as<JsonObject>().createNestedObject("mqtt");
+    root["localServers"]["mqtt"]["port"] = this->localServers.mqtt.port;
+    root.createNestedObject("remoteServers");
+    root["remoteServers"].as<JsonObject>().createNestedObject("mqtt");
+    root["remoteServers"]["mqtt"]["brokerAddress"] = this->remoteServers.mqtt.brokerAddress;
+    root["remoteServers"]["mqtt"]["brokerPort"] = this->remoteServers.mqtt.brokerPort;
+    root.createNestedObject("gas");
+    root["gas"]["publishDataPeriodMs"] = this->gas.publishDataPeriodMs;
+    root["gas"]["lastHeardFromPeriodS"] = this->gas.lastHeardFromPeriodS;
+    root.createNestedObject("weather");
+    root["weather"]["publishDataPeriodMs"] = this->weather.publishDataPeriodMs;
+
+    OUT(this->filename);
+    return true;
+  }//writeSettingsFile
+
+  int readSettingsFile() {
+    memset(this->lazyRanges, 0, sizeof this->lazyRanges);
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    IN(this->filename);
+    if (!settingsFile) return READ_FILE_NOT_FOUND;
+    LAZYRANGE lazyRanges[1];
+    skipLazy(settingsFile.json, lazyRanges);
+    JsonObject &root = jb.parseObject(settingsFile.json);
+    if (!root.success()) return READ_PARSE_FAIL;
+    if (strcmp(this->version, root["version"] | "")) return READ_VERSION_NO_MATCH;
+    this->testDouble = root["testDouble"].as<double>();
+    readDecimal(this->testStringDouble, root["testStringDouble"], 3);
+    this->device.name = root["device"]["name"].as<char*>();
+    this->device.serialDiagnostics = root["device"]["serialDiagnostics"].as<bool>();
+    this->device.fileDiagnostics = root["device"]["fileDiagnostics"].as<bool>();
+    this->device.diagnosticsFilename = root["device"]["diagnosticsFilename"].as<char*>();
+    this->device.fileLog = root["device"]["fileLog"].as<bool>();
+    this->device.logFilename = root["device"]["logFilename"].as<char*>();
+    this->device.reset = root["device"]["reset"].as<bool>();
+    this->device.wiFi.useMdns = root["device"]["wiFi"]["useMdns"].as<bool>();
+    this->device.wiFi.mdnsGatewayAddress = root["device"]["wiFi"]["mdnsGatewayAddress"].as<char*>();
+    setText(this->device.wiFi.accessPointMode.ssid, root["device"]["wiFi"]["accessPointMode"]["ssid"].as<const char*>());
+    setText(this->device.wiFi.accessPointMode.password, root["device"]["wiFi"]["accessPointMode"]["password"].as<const char*>());
+    readIpv4(this->device.wiFi.accessPointMode.ipAddress, root["device"]["wiFi"]["accessPointMode"]["ipAddress"]);
+    setText(this->device.wiFi.stationMode.ssid, root["device"]["wiFi"]["stationMode"]["ssid"].as<const char*>());
+    setText(this->device.wiFi.stationMode.key, root["device"]["wiFi"]["stationMode"]["key"].as<const char*>());
+    this->device.wiFi.stationMode.useDhcp = root["device"]["wiFi"]["stationMode"]["useDhcp"].as<bool>();
+    readIpv4(this->device.wiFi.stationMode.staticIpAddress, root["device"]["wiFi"]["stationMode"]["staticIpAddress"]);
+    readIpv4(this->device.wiFi.stationMode.gatewayAddress, root["device"]["wiFi"]["stationMode"]["gatewayAddress"]);
+    this->device.wiFi.stationMode.connectToApTimeoutMs = root["device"]["wiFi"]["stationMode"]["connectToApTimeoutMs"].as<long>();
+    readInteger(this->device.wiFi.stationMode.connectToApAttempts, root["device"]["wiFi"]["stationMode"]["connectToApAttempts"], 0, 20);
+    this->remoteServers.mqtt.brokerAddress = root["remoteServers"]["mqtt"]["brokerAddress"].as<char*>();
+    readInteger(this->remoteServers.mqtt.brokerPort, root["remoteServers"]["mqtt"]["brokerPort"], 0, 65535);
+    this->gas.publishDataPeriodMs = root["gas"]["publishDataPeriodMs"].as<long>();
+    this->gas.lastHeardFromPeriodS = root["gas"]["lastHeardFromPeriodS"].as<long>();
+    this->weather.publishDataPeriodMs = root["weather"]["publishDataPeriodMs"].as<long>();
+
+    settingsFile.close();
+    memcpy(this->lazyRanges, lazyRanges, sizeof lazyRanges);
+    return READ_OK;
+  }//readSettingsFile
+
+  template <size_t N> static bool setText(char (&to)[N], const char *from){
+    if (!from) from = "";
+    size_t n = strnlen(from, N - 1);
+    if (!strncmp(to, from, n) && !to[n]) return false;
+    memcpy(to, from, n);
+    to[n] = 0;
+    return true;
+  }
+
+
+  template <class T> static void readInteger(T &x, JsonVariant v, long minValue, long maxValue){
+    long n = v.as<long>(); //numbers, or numeric strings from before the field was narrowed
+    x = n < minValue ? minValue : n > maxValue ? maxValue : n;
+  }
+  static bool parseInteger(const char *s, long minValue, long maxValue, long &n){
+    char *end;
+    n = strtol(s, &end, 10);
+    return end != s && !*end && n >= minValue && n <= maxValue;
+  }
+
+
+  static bool parseDecimal(const char *s, int scale, long &n){ //exact; digits beyond the scale are rounded
+    bool negative = *s == '-';
+    if (*s == '-' || *s == '+') s++;
+    unsigned long v = 0;
+    int digits = 0, decimals = -1; //digits after the point; -1 before it
+    bool roundUp = false;
+    for (;; s++){
+      if (*s == '.' && decimals < 0) decimals = 0;
+      else if (*s >= '0' && *s <= '9'){
+        digits++;
+        if (decimals >= scale){
+          if (decimals++ == scale) roundUp = *s >= '5';
+          continue;
+        }
+        if (decimals >= 0) decimals++;
+        if (v > (2147483647ul - (*s - '0')) / 10) return false;
+        v = v * 10 + (*s - '0');
+      }
+      else break;
+    }
+    if (!digits || *s) return false;
+    for (decimals = decimals < 0 ? 0 : decimals; decimals < scale; decimals++){
+      if (v > 214748364ul) return false;
+      v *= 10;
+    }
+    if (roundUp && v++ == 2147483647ul) return false;
+    n = negative ? -(long)v : (long)v;
+    return true;
+  }
+  static char *formatDecimal(long n, int scale){ //into a buffer shared by every call, so use the text straight away
+    static char text[24];
+    char *p = text + sizeof text - 1;
+    unsigned long v = n < 0 ? 0ul - n : n;
+    *p = 0;
+    for (int i = 0; i < scale; i++, v /= 10) *--p = '0' + v % 10;
+    if (scale) *--p = '.';
+    do *--p = '0' + v % 10; while (v /= 10);
+    if (n < 0) *--p = '-';
+    return p;
+  }
+  static void readDecimal(long &x, JsonVariant v, int scale){
+    const char *s = v.as<const char *>(); //the text of a number, as parsed, or a numeric string
+    if (!s || !parseDecimal(s, scale, x)){ //missing, or eg: written with an exponent
+      static const long powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+      double d = v.as<double>() * powers[scale];
+      x = d < 0 ? d - 0.5 : d + 0.5;
+    }
+  }
+
+
+  static bool parseIpv4(const char *s, uint32_t &ip){ //"a.b.c.d", a in the low byte as in IPAddress; "" is 0
+    if (!*s) return ip = 0, true;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++){
+      unsigned octet = 0, digits = 0;
+      while (*s >= '0' && *s <= '9' && digits++ < 3) octet = octet * 10 + (*s++ - '0');
+      if (!digits || octet > 255 || *s != (i < 3 ? '.' : '\0')) return false;
+      if (i < 3) s++;
+      v |= (uint32_t)octet << (8 * i);
+    }
+    ip = v;
+    return true;
+  }
+  static char *formatIpv4(uint32_t ip){ //into a buffer shared by every call, so use the text straight away; 0 is ""
+    static char text[16];
+    char *p = text;
+    for (int i = 0; i < 4 && (ip || i); i++, ip >>= 8){
+      uint8_t octet = ip;
+      if (octet >= 100) *p++ = '0' + octet / 100;
+      if (octet >= 10) *p++ = '0' + octet / 10 % 10;
+      *p++ = '0' + octet % 10;
+      if (i < 3) *p++ = '.';
+    }
+    *p = 0;
+    return text;
+  }
+  static void readIpv4(uint32_t &x, JsonVariant v){
+    const char *s = v.as<const char *>();
+    if (!s || !parseIpv4(s, x)) x = 0;
+  }
+
+
+  typedef char NUMBERTEXT[26]; //room for any long or double as text
+  static char *formatLong(NUMBERTEXT &text, long n){ //returns the first character, somewhere in text
+    char *p = text + sizeof text - 1;
+    unsigned long v = n < 0 ? 0ul - n : n;
+    *p = 0;
+    do *--p = '0' + v % 10; while (v /= 10);
+    if (n < 0) *--p = '-';
+    return p;
+  }
+  static char *formatDouble(NUMBERTEXT &text, double d){ //the shortest text that reads back as d; NaN and Infinity as javascript has them
+    if (d - d != 0) return strcpy(text, d != d ? "NaN" : d < 0 ? "-Infinity" : "Infinity");
+    static const double powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    double a = d < 0 ? -d : d;
+    for (int places = 0; a < 1e9 && places <= 6; places++){ //a few decimal places, as most settings have, need no printf
+      unsigned long long v = a * powers[places] + 0.5;
+      if (v / powers[places] != a) continue; //the fewest places that read back as d
+      char *p = text + sizeof text - 1;
+      *p = 0;
+      for (int i = 0; i < places; i++, v /= 10) *--p = '0' + v % 10;
+      if (places) *--p = '.';
+      do *--p = '0' + v % 10; while (v /= 10);
+      if (d < 0) *--p = '-';
+      return p;
+    }
+    for (int digits = 15;; digits++){ //15 digits give any shorter decimal back exactly, 17 any double
+      snprintf(text, sizeof text, "%.*g", digits, d);
+      if (digits == 17 || strtod(text, nullptr) == d) return text;
+    }
+  }
+
+
+  enum FIELDFLAGS : uint8_t { FIELD_PRIVATE = 1, FIELD_READONLY = 2, FIELD_NOREAD = 4, FIELD_NOWRITE = 8, FIELD_VOLATILE = 16, FIELD_CONST = 32 };
+  template <typename Visitor> void visitFields(Visitor &&visit){ //visit(name, path, member, flags) for each field
+    this->loadLazy();
+    visit("version", "version", this->version, FIELD_READONLY | FIELD_CONST);
+    visit("filename", "filename", this->filename, FIELD_PRIVATE | FIELD_READONLY | FIELD_CONST);
+    visit("testDouble", "testDouble", this->testDouble, FIELD_PRIVATE);
+    visit("testStringDouble", "testStringDouble", this->testStringDouble, FIELD_PRIVATE);
+    visit("name", "device.name", this->device.name, 0);
+    visit("lastError", "device.lastError", this->device.lastError, FIELD_READONLY | FIELD_VOLATILE);
+    visit("serialDiagnostics", "device.serialDiagnostics", this->device.serialDiagnostics, 0);
+    visit("fileDiagnostics", "device.fileDiagnostics", this->device.fileDiagnostics, 0);
+    visit("diagnosticsFilename", "device.diagnosticsFilename", this->device.diagnosticsFilename, 0);
+    visit("fileLog", "device.fileLog", this->device.fileLog, 0);
+    visit("logFilename", "device.logFilename", this->device.logFilename, 0);
+    visit("reset", "device.reset", this->device.reset, 0);
+    visit("currentIpAddress", "device.wiFi.currentIpAddress", this->device.wiFi.currentIpAddress, FIELD_READONLY | FIELD_VOLATILE);
+    visit("useMdns", "device.wiFi.useMdns", this->device.wiFi.useMdns, 0);
+    visit("mdnsGatewayAddress", "device.wiFi.mdnsGatewayAddress", this->device.wiFi.mdnsGatewayAddress, 0);
+    visit("ssid", "device.wiFi.accessPointMode.ssid", this->device.wiFi.accessPointMode.ssid, 0);
+    visit("password", "device.wiFi.accessPointMode.password", this->device.wiFi.accessPointMode.password, 0);
+    visit("ipAddress", "device.wiFi.accessPointMode.ipAddress", this->device.wiFi.accessPointMode.ipAddress, 0);
+    visit("ssid", "device.wiFi.stationMode.ssid", this->device.wiFi.stationMode.ssid, 0);
+    visit("key", "device.wiFi.stationMode.key", this->device.wiFi.stationMode.key, 0);
+    visit("useDhcp", "device.wiFi.stationMode.useDhcp", this->device.wiFi.stationMode.useDhcp, 0);
+    visit("staticIpAddress", "device.wiFi.stationMode.staticIpAddress", this->device.wiFi.stationMode.staticIpAddress, 0);
+    visit("gatewayAddress", "device.wiFi.stationMode.gatewayAddress", this->device.wiFi.stationMode.gatewayAddress, 0);
+    visit("connectToApTimeoutMs", "device.wiFi.stationMode.connectToApTimeoutMs", this->device.wiFi.stationMode.connectToApTimeoutMs, 0);
+    visit("connectToApAttempts", "device.wiFi.stationMode.connectToApAttempts", this->device.wiFi.stationMode.connectToApAttempts, 0);
+    visit("port", "localServers.http.port", this->localServers.http.port, 0);
+    visit("indexForm", "localServers.http.indexForm", this->localServers.http.indexForm, FIELD_PRIVATE);
+    visit("settingsForm", "localServers.http.settingsForm", this->localServers.http.settingsForm, FIELD_PRIVATE);
+    visit("valuesJs", "localServers.http.valuesJs", this->localServers.http.valuesJs, FIELD_READONLY | FIELD_CONST);
+    visit("port", "localServers.mqtt.port", this->localServers.mqtt.port, 0);
+    visit("brokerAddress", "remoteServers.mqtt.brokerAddress", this->remoteServers.mqtt.brokerAddress, 0);
+    visit("brokerPort", "remoteServers.mqtt.brokerPort", this->remoteServers.mqtt.brokerPort, 0);
+    visit("publishDataPeriodMs", "gas.publishDataPeriodMs", this->gas.publishDataPeriodMs, 0);
+    visit("lastHeardFromPeriodS", "gas.lastHeardFromPeriodS", this->gas.lastHeardFromPeriodS, FIELD_PRIVATE);
+    visit("rev", "gas.diagnostics.rev", this->gas.diagnostics.rev, FIELD_READONLY);
+    visit("errors", "gas.diagnostics.errors", this->gas.diagnostics.errors, FIELD_READONLY | FIELD_VOLATILE);
+    visit("bounce1", "gas.diagnostics.extra.bounce1", this->gas.diagnostics.extra.bounce1, FIELD_READONLY);
+    visit("bounce2", "gas.diagnostics.extra.bounce2", this->gas.diagnostics.extra.bounce2, FIELD_READONLY);
+    visit("reset", "gas.diagnostics.extra.control.reset", this->gas.diagnostics.extra.control.reset, 0);
+    visit("publishDataPeriodMs", "weather.publishDataPeriodMs", this->weather.publishDataPeriodMs, 0);
+  }//visitFields
+
+  template <typename Visitor> void visitFields(Visitor &&visit) const{ //<LAZY> objects as loaded so far
+    visit("version", "version", this->version, FIELD_READONLY | FIELD_CONST);
+    visit("filename", "filename", this->filename, FIELD_PRIVATE | FIELD_READONLY | FIELD_CONST);
+    visit("testDouble", "testDouble", this->testDouble, FIELD_PRIVATE);
+    visit("testStringDouble", "testStringDouble", this->testStringDouble, FIELD_PRIVATE);
+    visit("name", "device.name", this->device.name, 0);
+    visit("lastError", "device.lastError", this->device.lastError, FIELD_READONLY | FIELD_VOLATILE);
+    visit("serialDiagnostics", "device.serialDiagnostics", this->device.serialDiagnostics, 0);
+    visit("fileDiagnostics", "device.fileDiagnostics", this->device.fileDiagnostics, 0);
+    visit("diagnosticsFilename", "device.diagnosticsFilename", this->device.diagnosticsFilename, 0);
+    visit("fileLog", "device.fileLog", this->device.fileLog, 0);
+    visit("logFilename", "device.logFilename", this->device.logFilename, 0);
+    visit("reset", "device.reset", this->device.reset, 0);
+    visit("currentIpAddress", "device.wiFi.currentIpAddress", this->device.wiFi.currentIpAddress, FIELD_READONLY | FIELD_VOLATILE);
+    visit("useMdns", "device.wiFi.useMdns", this->device.wiFi.useMdns, 0);
+    visit("mdnsGatewayAddress", "device.wiFi.mdnsGatewayAddress", this->device.wiFi.mdnsGatewayAddress, 0);
+    visit("ssid", "device.wiFi.accessPointMode.ssid", this->device.wiFi.accessPointMode.ssid, 0);
+    visit("password", "device.wiFi.accessPointMode.password", this->device.wiFi.accessPointMode.password, 0);
+    visit("ipAddress", "device.wiFi.accessPointMode.ipAddress", this->device.wiFi.accessPointMode.ipAddress, 0);
+    visit("ssid", "device.wiFi.stationMode.ssid", this->device.wiFi.stationMode.ssid, 0);
+    visit("key", "device.wiFi.stationMode.key", this->device.wiFi.stationMode.key, 0);
+    visit("useDhcp", "device.wiFi.stationMode.useDhcp", this->device.wiFi.stationMode.useDhcp, 0);
+    visit("staticIpAddress", "device.wiFi.stationMode.staticIpAddress", this->device.wiFi.stationMode.staticIpAddress, 0);
+    visit("gatewayAddress", "device.wiFi.stationMode.gatewayAddress", this->device.wiFi.stationMode.gatewayAddress, 0);
+    visit("connectToApTimeoutMs", "device.wiFi.stationMode.connectToApTimeoutMs", this->device.wiFi.stationMode.connectToApTimeoutMs, 0);
+    visit("connectToApAttempts", "device.wiFi.stationMode.connectToApAttempts", this->device.wiFi.stationMode.connectToApAttempts, 0);
+    visit("port", "localServers.http.port", this->localServers.http.port, 0);
+    visit("indexForm", "localServers.http.indexForm", this->localServers.http.indexForm, FIELD_PRIVATE);
+    visit("settingsForm", "localServers.http.settingsForm", this->localServers.http.settingsForm, FIELD_PRIVATE);
+    visit("valuesJs", "localServers.http.valuesJs", this->localServers.http.valuesJs, FIELD_READONLY | FIELD_CONST);
+    visit("port", "localServers.mqtt.port", this->localServers.mqtt.port, 0);
+    visit("brokerAddress", "remoteServers.mqtt.brokerAddress", this->remoteServers.mqtt.brokerAddress, 0);
+    visit("brokerPort", "remoteServers.mqtt.brokerPort", this->remoteServers.mqtt.brokerPort, 0);
+    visit("publishDataPeriodMs", "gas.publishDataPeriodMs", this->gas.publishDataPeriodMs, 0);
+    visit("lastHeardFromPeriodS", "gas.lastHeardFromPeriodS", this->gas.lastHeardFromPeriodS, FIELD_PRIVATE);
+    visit("rev", "gas.diagnostics.rev", this->gas.diagnostics.rev, FIELD_READONLY);
+    visit("errors", "gas.diagnostics.errors", this->gas.diagnostics.errors, FIELD_READONLY | FIELD_VOLATILE);
+    visit("bounce1", "gas.diagnostics.extra.bounce1", this->gas.diagnostics.extra.bounce1, FIELD_READONLY);
+    visit("bounce2", "gas.diagnostics.extra.bounce2", this->gas.diagnostics.extra.bounce2, FIELD_READONLY);
+    visit("reset", "gas.diagnostics.extra.control.reset", this->gas.diagnostics.extra.control.reset, 0);
+    visit("publishDataPeriodMs", "weather.publishDataPeriodMs", this->weather.publishDataPeriodMs, 0);
+  }//visitFields
+
+
+  static uint32_t fingerprintOf(uint32_t h, const void *p, size_t n){
+    for (const uint8_t *b = (const uint8_t *)p; n--; b++) h = (h ^ *b) * 16777619u;
+    return h;
+  }
+  template <class T> static uint32_t fingerprintOf(uint32_t h, const T &v){ return fingerprintOf(h, &v, sizeof v); }
+  template <size_t N> static uint32_t fingerprintOf(uint32_t h, const char (&s)[N]){ return fingerprintOf(h, s, strnlen(s, N - 1) + 1); }
+  static uint32_t fingerprintOf(uint32_t h, const String &s){ return fingerprintOf(h, s.c_str(), s.length() + 1); }
+  static uint32_t fingerprintOf(uint32_t h, double d){
+    if (d != d) return fingerprintOf(h, (uint64_t)0x7FF8000000000000u); //every NaN as the one quiet NaN
+    if (d == 0) d = 0; //-0.0 as 0.0
+    return fingerprintOf(h, &d, sizeof d);
+  }
+  static bool sameValue(double a, double b){ return a == b || (a != a && b != b); } //NaN is NaN, so a copy equals its original
+  uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+    h = fingerprintOf(h, this->testDouble);
+    h = fingerprintOf(h, this->testStringDouble);
+    h = this->device.fingerprint(h);
+    h = this->localServers.fingerprint(h);
+    h = this->remoteServers.fingerprint(h);
+    h = this->gas.fingerprint(h);
+    h = this->weather.fingerprint(h);
+    return h;
+  }
+  bool operator==(const SETTINGS &o) const{ //the persisted fields are equal
+    return sameValue(this->testDouble, o.testDouble) && this->testStringDouble == o.testStringDouble && this->device == o.device && this->localServers == o.localServers && this->remoteServers == o.remoteServers && this->gas == o.gas && this->weather == o.weather;
+  }
+  bool operator!=(const SETTINGS &o) const{ return !(*this == o); }
+  uint32_t fingerprint(uint32_t h = 2166136261u){ //<LAZY> objects loaded first
+    this->loadLazy();
+    return static_cast<const SETTINGS &>(*this).fingerprint(h);
+  }
+  bool operator==(SETTINGS &o){ //<LAZY> objects of both loaded first
+    this->loadLazy();
+    o.loadLazy();
+    return static_cast<const SETTINGS &>(*this) == static_cast<const SETTINGS &>(o);
+  }
+  bool operator!=(SETTINGS &o){ return !(*this == o); }
+
+
+  bool writeGasDiagnostics() {
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    JsonObject &root = jb.createObject();
+    root["rev"] = this->gas.diagnostics.rev;
+    root.createNestedObject("extra");
+    root["extra"]["bounce1"] = this->gas.diagnostics.extra.bounce1;
+    root["extra"]["bounce2"] = this->gas.diagnostics.extra.bounce2;
+    root["extra"].as<JsonObject>().createNestedObject("control");
+    root["extra"]["control"]["reset"] = this->gas.diagnostics.extra.control.reset;
+
+    OUT("/gasDiag.json");
+    return true;
+  }//writeGasDiagnostics
+
+  int readGasDiagnostics() {
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    IN("/gasDiag.json");
+    if (!settingsFile) return this->readGasDiagnosticsFromSettingsFile();
+    JsonObject &root = jb.parseObject(settingsFile.json);
+    if (!root.success()) return READ_PARSE_FAIL;
+    this->gas.diagnostics.rev = root["rev"].as<long>();
+    this->gas.diagnostics.extra.bounce1 = root["extra"]["bounce1"].as<long>();
+    this->gas.diagnostics.extra.bounce2 = root["extra"]["bounce2"].as<long>();
+    this->gas.diagnostics.extra.control.reset = root["extra"]["control"]["reset"].as<bool>();
+
+    settingsFile.close();
+    return READ_OK;
+  }//readGasDiagnostics
+
+  int readGasDiagnosticsFromSettingsFile() { //no /gasDiag.json yet: take the object from the settings file, or keep the defaults
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    IN(this->filename);
+    if (!settingsFile) return READ_OK;
+    JsonObject &settingsRoot = jb.parseObject(settingsFile.json);
+    JsonObject &root = settingsRoot["gas"]["diagnostics"].as<JsonObject>();
+    if (!root.success()) return READ_OK;
+    this->gas.diagnostics.rev = root["rev"].as<long>();
+    this->gas.diagnostics.extra.bounce1 = root["extra"]["bounce1"].as<long>();
+    this->gas.diagnostics.extra.bounce2 = root["extra"]["bounce2"].as<long>();
+    this->gas.diagnostics.extra.control.reset = root["extra"]["control"]["reset"].as<bool>();
+
+    settingsFile.close();
+    return READ_OK;
+  }//readGasDiagnosticsFromSettingsFile
+
+  bool write() {
+    bool ok = true;
+    ok = this->writeGasDiagnostics() && ok;
+    return this->writeSettingsFile() && ok;
+  }//write
+
+  int read() {
+    int r = this->readSettingsFile();
+    if (r != READ_OK) return r;
+    r = this->readGasDiagnostics();
+    return r;
+  }//read
+
+
+  static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0){ //crc is that of the bytes before p, if any
+    static const uint32_t nibbles[16] = {
+      0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+      0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu};
+    crc = ~crc;
+    while (n--){
+      crc = nibbles[(crc ^ *p) & 0x0F] ^ (crc >> 4);
+      crc = nibbles[(crc ^ (*p++ >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+  }//crc32
+
+#ifdef Arduino_h
+  static uint8_t *loadBytes(const char *f, size_t &n, size_t limit = (size_t)-1, size_t offset = 0){
+    recoverFile(f);
+    File file = SPIFFS.open(f, "r");
+    if (!file || file.size() < offset || !file.seek(offset, SeekSet)) return nullptr;
+    n = min((size_t)file.size() - offset, limit);
+    uint8_t *buf = (uint8_t *)malloc(n + 1);
+    if (buf && file.read(buf, n) != n){
+      free(buf);
+      buf = nullptr;
+    }
+    if (buf) buf[n] = 0;
+    file.close();
+    return buf;
+  }//loadBytes
+
+  static bool saveBytes(const char *f, const uint8_t *buf, size_t n, const char *mode = "w"){
+    //a whole file is written to a temporary file first; SPIFFS won't rename over f, so it is removed just before the rename
+    String temp = *mode == 'a' ? String(f) : String(f) + ".tmp";
+    File file = SPIFFS.open(temp, mode);
+    if (!file) return false;
+    bool ok = file.write(buf, n) == n;
+    file.close();
+    if (*mode == 'a') return ok;
+    if (!ok){
+      SPIFFS.remove(temp);
+      return false;
+    }
+    return removeFile(f) && SPIFFS.rename(temp, f);
+  }//saveBytes
+
+  static void recoverFile(const char *f){ //a power cut between saveBytes() removing f and renaming its replacement leaves just the replacement
+    String temp = String(f) + ".tmp";
+    if (!SPIFFS.exists(f) && SPIFFS.exists(temp)) SPIFFS.rename(temp, f);
+  }
+
+  static bool removeFile(const char *f){
+    return !SPIFFS.exists(f) || SPIFFS.remove(f);
+  }
+#else
+  static uint8_t *loadBytes(const char *f, size_t &n, size_t limit = (size_t)-1, size_t offset = 0){
+    ifstream file(f, ios::binary | ios::ate);
+    if (!file || (size_t)file.tellg() < offset) return nullptr;
+    n = min((size_t)file.tellg() - offset, limit);
+    file.seekg(offset);
+    uint8_t *buf = (uint8_t *)malloc(n + 1);
+    if (buf && !file.read((char *)buf, n)){
+      free(buf);
+      buf = nullptr;
+    }
+    if (buf) buf[n] = 0;
+    return buf;
+  }//loadBytes
+
+  static bool saveBytes(const char *f, const uint8_t *buf, size_t n, const char *mode = "w"){
+    if (*mode == 'a'){
+      ofstream file(f, ios::binary | ios::app);
+      file.write((const char *)buf, n);
+      file.close();
+      return !file.fail();
+    }
+    //write a temporary file and rename it over f; f is always either the old or the new version
+    string temp = string(f) + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(buf, 1, n, file) == n && !fflush(file) && !fsync(fileno(file));
+    ok = !fclose(file) && ok && !rename(temp.c_str(), f);
+    if (!ok){
+      ::remove(temp.c_str());
+      return false;
+    }
+    string directory(f);
+    directory = directory.substr(0, directory.find_last_of('/') + 1);
+    int d = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (d >= 0){
+      fsync(d); //make the rename itself durable
+      close(d);
+    }
+    return true;
+  }//saveBytes
+
+  static void recoverFile(const char *){} //rename() replaces f in one step, so there is nothing to recover
+
+  static bool removeFile(const char *f){
+    return !::remove(f) || errno == ENOENT;
+  }
+#endif
+
+  template <class T> static uint8_t *binPut(uint8_t *p, const T &v){
+    memcpy(p, &v, sizeof v);
+    return p + sizeof v;
+  }
+  static uint8_t *binPut(uint8_t *p, const String &s){
+    uint16_t n = s.length();
+    memcpy(p, &n, 2);
+    memcpy(p + 2, s.c_str(), n + 1);
+    return p + n + 3;
+  }
+  template <class T> static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, T &v){
+    if (!p || p + sizeof v > end) return nullptr;
+    memcpy(&v, p, sizeof v);
+    return p + sizeof v;
+  }
+  static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, String &s){
+    uint16_t n;
+    if (!(p = binGet(p, end, n)) || p + n >= end || p[n]) return nullptr;
+    s = (const char *)p;
+    return p + n + 1;
+  }
+  template <class T> static size_t binSize(const T &v){
+    return sizeof v;
+  }
+  static size_t binSize(const String &s){
+    return s.length() + 3;
+  }
+  template <size_t N> static uint8_t *binPut(uint8_t *p, const char (&s)[N]){
+    uint16_t n = strlen(s);
+    memcpy(p, &n, 2);
+    memcpy(p + 2, s, n + 1);
+    return p + n + 3;
+  }
+  template <size_t N> static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, char (&s)[N]){
+    uint16_t n;
+    if (!(p = binGet(p, end, n)) || n >= N || p + n >= end || p[n]) return nullptr;
+    memcpy(s, p, n + 1);
+    return p + n + 1;
+  }
+  template <size_t N> static size_t binSize(const char (&s)[N]){
+    return strlen(s) + 3;
+  }
+
+
+  struct JSONTEXT { //a settings file loaded into memory; json is 0 terminated
+    char *json = nullptr;
+    size_t length = 0;
+    operator bool() const { return json != nullptr; }
+    void close(){
+      free(this->json);
+      this->json = nullptr;
+    }
+    ~JSONTEXT(){ free(this->json); }
+  };
+
+
+  struct LAZYRANGE {
+    uint32_t offset, length; //of the object's json in the settings file; length is 0 once it has been loaded
+  } lazyRanges[1] = {};
+
+  static const char *jsonSkipSpace(const char *p){
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+  }
+
+  static const char *jsonSkipValue(const char *p){ //p at the start of a value; returns the end of it or nullptr
+    int depth = 0;
+    for (;; p++){
+      switch (*p){
+        case 0: return nullptr;
+        case '"':
+          for (p++; *p != '"'; p++){
+            if (!*p) return nullptr;
+            if (*p == '\\' && p[1]) p++;
+          }
+          if (!depth) return p + 1;
+          break;
+        case '{': case '[': depth++; break;
+        case '}': case ']':
+          if (!depth) return p; //end of a number, true, false or null
+          if (!--depth) return p + 1;
+          break;
+        case ',':
+          if (!depth) return p;
+          break;
+      }
+    }
+  }
+
+  static const char *jsonFindMember(const char *p, const char *key){ //p at the '{' of an object; returns the start of key's value or nullptr
+    size_t n = strlen(key);
+    for (p = jsonSkipSpace(p + 1); *p == '"'; p = jsonSkipSpace(p)){
+      const char *name = p + 1;
+      p = jsonSkipValue(p);
+      if (!p) return nullptr;
+      bool found = (size_t)(p - 1 - name) == n && !strncmp(name, key, n);
+      p = jsonSkipSpace(p);
+      if (*p != ':') return nullptr;
+      p = jsonSkipSpace(p + 1);
+      if (found) return p;
+      p = jsonSkipValue(p);
+      if (!p) return nullptr;
+      p = jsonSkipSpace(p);
+      if (*p == ',') p++;
+    }
+    return nullptr;
+  }
+
+  static void skipLazy(char *json, LAZYRANGE *ranges){
+    const char *p, *end;
+    ranges[0].length = 0;
+    p = jsonSkipSpace(json);
+    if (*p == '{') p = jsonFindMember(p, "localServers");
+    if (!p) p = "";
+    end = *p == '{' ? jsonSkipValue(p) : nullptr;
+    if (end){
+      ranges[0].offset = p - json;
+      ranges[0].length = end - p;
+      memset(json + ranges[0].offset + 1, ' ', ranges[0].length - 2);
+    }
+  }//skipLazy
+
+  bool loadLazy(int i){ //false if the object couldn't be loaded
+    LAZYRANGE range = this->lazyRanges[i];
+    if (!range.length) return true;
+    size_t n;
+    char *json = (char *)loadBytes(String(this->filename).c_str(), n, range.length, range.offset);
+    if (!json) return false;
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    JsonObject &root = jb.parseObject(json);
+    bool ok = n == range.length && root.success();
+    if (ok) switch (i){
+      case 0:
+        readInteger(this->localServers.http.port, root["http"]["port"], 0, 65535);
+        this->localServers.http.indexForm = root["http"]["indexForm"].as<char*>();
+        this->localServers.http.settingsForm = root["http"]["settingsForm"].as<char*>();
+        readInteger(this->localServers.mqtt.port, root["mqtt"]["port"], 0, 65535);
+        break;
+    }
+    free(json);
+    if (ok) this->lazyRanges[i].length = 0; //tried again next time otherwise
+    return ok;
+  }//loadLazy
+
+  bool loadLazy(){
+    bool ok = true;
+    for (int i = 0; i < 1; i++) ok = this->loadLazy(i) && ok;
+    return ok;
+  }
+
+
+  LOCALSERVERS &getLocalServers(){ //<LAZY>: loaded on first use
+    this->loadLazy(0);
+    return this->localServers;
+  }
+
+  String getValuesScript(){
+    this->loadLazy();
+    String retval = "";
+    NUMBERTEXT number;
+    retval += String("var values = {};") + "\n";
+    retval += String("values['version'] = ") + "'" + this->version + "'" + ";\n";
+    retval += String("values['device.name'] = ") + "'" + this->device.name + "'" + ";\n";
+    retval += String("values['device.lastError'] = ") + "'" + this->device.lastError + "'" + ";\n";
+    retval += String("document.getElementById('device.serialDiagnostics').checked = ") + (this->device.serialDiagnostics ? "true" : "false") + ";\n";
+    retval += String("document.getElementById('device.fileDiagnostics').checked = ") + (this->device.fileDiagnostics ? "true" : "false") + ";\n";
+    retval += String("values['device.diagnosticsFilename'] = ") + "'" + this->device.diagnosticsFilename + "'" + ";\n";
+    retval += String("document.getElementById('device.fileLog').checked = ") + (this->device.fileLog ? "true" : "false") + ";\n";
+    retval += String("values['device.logFilename'] = ") + "'" + this->device.logFilename + "'" + ";\n";
+    retval += String("document.getElementById('device.reset').checked = ") + (this->device.reset ? "true" : "false") + ";\n";
+    retval += String("values['device.wiFi.currentIpAddress'] = ") + "'" + formatIpv4(this->device.wiFi.currentIpAddress) + "'" + ";\n";
+    retval += String("document.getElementById('device.wiFi.useMdns').checked = ") + (this->device.wiFi.useMdns ? "true" : "false") + ";\n";
+    retval += String("values['device.wiFi.mdnsGatewayAddress'] = ") + "'" + this->device.wiFi.mdnsGatewayAddress + "'" + ";\n";
+    retval += String("values['device.wiFi.accessPointMode.ssid'] = ") + "'" + this->device.wiFi.accessPointMode.ssid + "'" + ";\n";
+    retval += String("values['device.wiFi.accessPointMode.password'] = ") + "'" + this->device.wiFi.accessPointMode.password + "'" + ";\n";
+    retval += String("values['device.wiFi.accessPointMode.ipAddress'] = ") + "'" + formatIpv4(this->device.wiFi.accessPointMode.ipAddress) + "'" + ";\n";
+    retval += String("values['device.wiFi.stationMode.ssid'] = ") + "'" + this->device.wiFi.stationMode.ssid + "'" + ";\n";
+    retval += String("values['device.wiFi.stationMode.key'] = ") + "'" + this->device.wiFi.stationMode.key + "'" + ";\n";
+    retval += String("document.getElementById('device.wiFi.stationMode.useDhcp').checked = ") + (this->device.wiFi.stationMode.useDhcp ? "true" : "false") + ";\n";
+    retval += String("values['device.wiFi.stationMode.staticIpAddress'] = ") + "'" + formatIpv4(this->device.wiFi.stationMode.staticIpAddress) + "'" + ";\n";
+    retval += String("values['device.wiFi.stationMode.gatewayAddress'] = ") + "'" + formatIpv4(this->device.wiFi.stationMode.gatewayAddress) + "'" + ";\n";
+    retval += String("values['device.wiFi.stationMode.connectToApTimeoutMs'] = ") + formatLong(number, this->device.wiFi.stationMode.connectToApTimeoutMs) + ";\n";
+    retval += String("values['device.wiFi.stationMode.connectToApAttempts'] = ") + formatLong(number, this->device.wiFi.stationMode.connectToApAttempts) + ";\n";
+    retval += String("values['localServers.http.port'] = ") + formatLong(number, this->localServers.http.port) + ";\n";
+    retval += String("values['localServers.http.valuesJs'] = ") + "'" + this->localServers.http.valuesJs + "'" + ";\n";
+    retval += String("values['localServers.mqtt.port'] = ") + formatLong(number, this->localServers.mqtt.port) + ";\n";
+    retval += String("values['remoteServers.mqtt.brokerAddress'] = ") + "'" + this->remoteServers.mqtt.brokerAddress + "'" + ";\n";
+    retval += String("values['remoteServers.mqtt.brokerPort'] = ") + formatLong(number, this->remoteServers.mqtt.brokerPort) + ";\n";
+    retval += String("values['gas.publishDataPeriodMs'] = ") + formatLong(number, this->gas.publishDataPeriodMs) + ";\n";
+    retval += String("values['gas.diagnostics.rev'] = ") + formatLong(number, this->gas.diagnostics.rev) + ";\n";
+    retval += String("values['gas.diagnostics.errors'] = ") + formatLong(number, this->gas.diagnostics.errors) + ";\n";
+    retval += String("values['gas.diagnostics.extra.bounce1'] = ") + formatLong(number, this->gas.diagnostics.extra.bounce1) + ";\n";
+    retval += String("values['gas.diagnostics.extra.bounce2'] = ") + formatLong(number, this->gas.diagnostics.extra.bounce2) + ";\n";
+    retval += String("document.getElementById('gas.diagnostics.extra.control.reset').checked = ") + (this->gas.diagnostics.extra.control.reset ? "true" : "false") + ";\n";
+    retval += String("values['weather.publishDataPeriodMs'] = ") + formatLong(number, this->weather.publishDataPeriodMs) + ";\n";
+
+    retval += "for (var key in values) {";
+    retval += "  document.getElementById(key).value = values[key];";
+    retval += "}";
+    return retval;
+  }//getValuesScript
+
+
+  static uint32_t submitSlot(const char *name){ //perfect hash of the submittable field names
+    uint32_t h = 2166137370u;
+    while (*name){
+      h ^= (uint8_t)*name++;
+      h *= 16777619u;
+    }
+    return h % 53;
+  }//submitSlot
+
+  template <class WEBSERVER> void submit(WEBSERVER &server){
+    this->loadLazy(); //so the fields submitted aren't overwritten later
+    uint8_t checked[1] = {0};
+    long n;
+    uint32_t ip;
+    for (int i = 0; i < server.args(); i++){
+      const String &name = server.argName(i);
+      const String &value = server.arg(i);
+      switch (submitSlot(name.c_str())){
+        case 0:
+          if (!strcmp(name.c_str(), "device.fileDiagnostics")) checked[0] |= 2;
+          break;
+        case 1:
+          if (!strcmp(name.c_str(), "device.serialDiagnostics")) checked[0] |= 1;
+          break;
+        case 2:
+          if (!strcmp(name.c_str(), "remoteServers.mqtt.brokerAddress")) this->remoteServers.mqtt.brokerAddress = value;
+          break;
+        case 4:
+          if (!strcmp(name.c_str(), "remoteServers.mqtt.brokerPort") && parseInteger(value.c_str(), 0, 65535, n)) this->remoteServers.mqtt.brokerPort = (uint16_t)n;
+          break;
+        case 8:
+          if (!strcmp(name.c_str(), "localServers.http.port") && parseInteger(value.c_str(), 0, 65535, n)) this->localServers.http.port = (uint16_t)n;
+          break;
+        case 9:
+          if (!strcmp(name.c_str(), "device.name")) this->device.name = value;
+          break;
+        case 13:
+          if (!strcmp(name.c_str(), "localServers.mqtt.port") && parseInteger(value.c_str(), 0, 65535, n)) this->localServers.mqtt.port = (uint16_t)n;
+          break;
+        case 14:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.useDhcp")) checked[0] |= 32;
+          break;
+        case 15:
+          if (!strcmp(name.c_str(), "weather.publishDataPeriodMs")) this->weather.publishDataPeriodMs = strtol(value.c_str(), nullptr, 10);
+          break;
+        case 21:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.connectToApAttempts") && parseInteger(value.c_str(), 0, 20, n)) this->device.wiFi.stationMode.connectToApAttempts = (uint8_t)n;
+          break;
+        case 22:
+          if (!strcmp(name.c_str(), "device.wiFi.accessPointMode.password")) setText(this->device.wiFi.accessPointMode.password, value.c_str());
+          break;
+        case 24:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.ssid")) setText(this->device.wiFi.stationMode.ssid, value.c_str());
+          break;
+        case 25:
+          if (!strcmp(name.c_str(), "gas.publishDataPeriodMs")) this->gas.publishDataPeriodMs = strtol(value.c_str(), nullptr, 10);
+          break;
+        case 26:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.gatewayAddress") && parseIpv4(value.c_str(), ip)) this->device.wiFi.stationMode.gatewayAddress = ip;
+          break;
+        case 29:
+          if (!strcmp(name.c_str(), "device.wiFi.accessPointMode.ipAddress") && parseIpv4(value.c_str(), ip)) this->device.wiFi.accessPointMode.ipAddress = ip;
+          break;
+        case 30:
+          if (!strcmp(name.c_str(), "device.fileLog")) checked[0] |= 4;
+          break;
+        case 31:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.staticIpAddress") && parseIpv4(value.c_str(), ip)) this->device.wiFi.stationMode.staticIpAddress = ip;
+          break;
+        case 34:
+          if (!strcmp(name.c_str(), "device.wiFi.accessPointMode.ssid")) setText(this->device.wiFi.accessPointMode.ssid, value.c_str());
+          break;
+        case 35:
+          if (!strcmp(name.c_str(), "gas.diagnostics.extra.control.reset")) checked[0] |= 64;
+          break;
+        case 36:
+          if (!strcmp(name.c_str(), "device.reset")) checked[0] |= 8;
+          break;
+        case 44:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.connectToApTimeoutMs")) this->device.wiFi.stationMode.connectToApTimeoutMs = strtol(value.c_str(), nullptr, 10);
+          break;
+        case 46:
+          if (!strcmp(name.c_str(), "device.diagnosticsFilename")) this->device.diagnosticsFilename = value;
+          break;
+        case 47:
+          if (!strcmp(name.c_str(), "device.wiFi.useMdns")) checked[0] |= 16;
+          break;
+        case 48:
+          if (!strcmp(name.c_str(), "device.wiFi.mdnsGatewayAddress")) this->device.wiFi.mdnsGatewayAddress = value;
+          break;
+        case 51:
+          if (!strcmp(name.c_str(), "device.logFilename")) this->device.logFilename = value;
+          break;
+        case 52:
+          if (!strcmp(name.c_str(), "device.wiFi.stationMode.key")) setText(this->device.wiFi.stationMode.key, value.c_str());
+          break;
+      }
+    }
+    this->device.fileDiagnostics = checked[0] & 2;
+    this->device.serialDiagnostics = checked[0] & 1;
+    this->device.wiFi.stationMode.useDhcp = checked[0] & 32;
+    this->device.fileLog = checked[0] & 4;
+    this->gas.diagnostics.extra.control.reset = checked[0] & 64;
+    this->device.reset = checked[0] & 8;
+    this->device.wiFi.useMdns = checked[0] & 16;
+  }//submit
+
+} settings;
+constexpr char SETTINGS::version[];
+constexpr char SETTINGS::filename[];
+constexpr char SETTINGS::LOCALSERVERS::HTTP::valuesJs[];
+
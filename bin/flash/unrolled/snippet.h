@@ -0,0 +1,3 @@
+//void handleSubmitSettings(){
+  settings.submit(webServer);
+//}//handleSubmitSettings
\ No newline at end of file
@@ -0,0 +1,662 @@
+// Generated on 19Oct26 10:02.
+
+#pragma once
+
+
+#ifdef Arduino_h
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#define JSON_BUF_SIZE 3000
+
+#define OUT(f)\
+    File settingsFile = SPIFFS.open(f, "w");\
+    root.prettyPrintTo(settingsFile);\
+    settingsFile.close();
+    
+#ifndef READ_BUF_SIZE
+#define READ_BUF_SIZE 256 //bytes read() takes from the settings file at a time; a SPIFFS page
+#endif
+#define IN(f)\
+    BLOCKREADER settingsFile(SPIFFS.open(f, "r"));
+
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "ArduinoJson-v5.13.4.h"
+
+#define String string
+#define JSON_BUF_SIZE 3000
+
+#define OUT(f)\
+    string buf;\
+    root.prettyPrintTo(buf);\
+    ofstream settingsFile(f);\
+    settingsFile << buf;\
+    settingsFile.close();
+#ifndef READ_BUF_SIZE
+#define READ_BUF_SIZE 4096 //bytes read() takes from the settings file at a time, when it can't be mapped
+#endif
+#define IN(f)\
+    BLOCKREADER settingsFile(String(f).c_str());
+#endif
+
+#define READ_OK 0
+#define READ_PARSE_FAIL 1
+#define READ_VERSION_NO_MATCH 2
+#define READ_FILE_NOT_FOUND 3
+
+#ifndef JOURNAL_COMPACT_BYTES
+#define JOURNAL_COMPACT_BYTES 1024 //writeDirty() compacts the journal into the settings file once it grows past this
+#endif
+
+using namespace std;
+
+struct SETTINGS{
+  static constexpr char version[] = "1.0";
+  static constexpr char filename[] = "settings.json";
+  String name = "journal";
+  long count = 0;
+  bool enabled = true;
+  double ratio = 0.5;
+  struct NETWORK {
+    char ssid[33] = "MY_SSID";
+    uint16_t port = 80;
+    uint32_t address = 0x0104A8C0u;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = fingerprintOf(h, this->ssid);
+      h = fingerprintOf(h, this->port);
+      h = fingerprintOf(h, this->address);
+      return h;
+    }
+    bool operator==(const NETWORK &o) const{ //the persisted fields are equal
+      return !strcmp(this->ssid, o.ssid) && this->port == o.port && this->address == o.address;
+    }
+    bool operator!=(const NETWORK &o) const{ return !(*this == o); }
+  }network;
+
+  bool write() {
+    if ((this->journalBytes == (size_t)-1 || (this->journalBytes && !this->appendJournal(true))) && !removeFile(journalFilename().c_str())) return false;
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    JsonObject &root = jb.createObject();
+    root["version"] = this->version;
+    root["name"] = this->name;
+    root["count"] = this->count;
+    root["enabled"] = this->enabled;
+    root["ratio"] = this->ratio;
+    root.createNestedObject("network");
+    root["network"]["ssid"] = this->network.ssid;
+    root["network"]["port"] = this->network.port;
+    root["network"]["address"] = formatIpv4(this->network.address);
+
+    String json;
+    root.prettyPrintTo(json);
+    if (!saveBytes(this->filename, (const uint8_t *)json.c_str(), json.length())) return false;
+    if (!removeFile(journalFilename().c_str())) return false;
+    this->journalBytes = 0;
+    this->clearDirty();
+    return true;
+  }//write
+
+  int read() {
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    recoverFile(this->filename);
+    IN(this->filename);
+    if (!settingsFile){
+      if (!this->replayJournal()){
+        this->journalBytes = (size_t)-1; //writeDirty() writes the whole file
+        return READ_FILE_NOT_FOUND;
+      }
+      this->clearDirty();
+      return READ_OK;
+    }
+    JsonObject &root = settingsFile.parseObject(jb);
+    if (!root.success()){
+      if (!this->replayJournal()){
+        this->journalBytes = (size_t)-1; //writeDirty() writes the whole file
+        return READ_PARSE_FAIL;
+      }
+      this->clearDirty();
+      return READ_OK;
+    }
+    if (strcmp(this->version, root["version"] | "")) return READ_VERSION_NO_MATCH;
+    this->name = root["name"].as<char*>();
+    this->count = root["count"].as<long>();
+    this->enabled = root["enabled"].as<bool>();
+    this->ratio = root["ratio"].as<double>();
+    setText(this->network.ssid, root["network"]["ssid"].as<const char*>());
+    readInteger(this->network.port, root["network"]["port"], 0, 65535);
+    readIpv4(this->network.address, root["network"]["address"]);
+
+    settingsFile.close();
+    this->replayJournal();
+    this->clearDirty();
+    return READ_OK;
+  }//read
+
+  template <size_t N> static bool setText(char (&to)[N], const char *from){
+    if (!from) from = "";
+    size_t n = strnlen(from, N - 1);
+    if (!strncmp(to, from, n) && !to[n]) return false;
+    memcpy(to, from, n);
+    to[n] = 0;
+    return true;
+  }
+
+
+  template <class T> static void readInteger(T &x, JsonVariant v, long minValue, long maxValue){
+    long n = v.as<long>(); //numbers, or numeric strings from before the field was narrowed
+    x = n < minValue ? minValue : n > maxValue ? maxValue : n;
+  }
+  static bool parseInteger(const char *s, long minValue, long maxValue, long &n){
+    char *end;
+    n = strtol(s, &end, 10);
+    return end != s && !*end && n >= minValue && n <= maxValue;
+  }
+
+
+  static bool parseIpv4(const char *s, uint32_t &ip){ //"a.b.c.d", a in the low byte as in IPAddress; "" is 0
+    if (!*s) return ip = 0, true;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++){
+      unsigned octet = 0, digits = 0;
+      while (*s >= '0' && *s <= '9' && digits++ < 3) octet = octet * 10 + (*s++ - '0');
+      if (!digits || octet > 255 || *s != (i < 3 ? '.' : '\0')) return false;
+      if (i < 3) s++;
+      v |= (uint32_t)octet << (8 * i);
+    }
+    ip = v;
+    return true;
+  }
+  static char *formatIpv4(uint32_t ip){ //into a buffer shared by every call, so use the text straight away; 0 is ""
+    static char text[16];
+    char *p = text;
+    for (int i = 0; i < 4 && (ip || i); i++, ip >>= 8){
+      uint8_t octet = ip;
+      if (octet >= 100) *p++ = '0' + octet / 100;
+      if (octet >= 10) *p++ = '0' + octet / 10 % 10;
+      *p++ = '0' + octet % 10;
+      if (i < 3) *p++ = '.';
+    }
+    *p = 0;
+    return text;
+  }
+  static void readIpv4(uint32_t &x, JsonVariant v){
+    const char *s = v.as<const char *>();
+    if (!s || !parseIpv4(s, x)) x = 0;
+  }
+
+
+  typedef char NUMBERTEXT[26]; //room for any long or double as text
+  static char *formatLong(NUMBERTEXT &text, long n){ //returns the first character, somewhere in text
+    char *p = text + sizeof text - 1;
+    unsigned long v = n < 0 ? 0ul - n : n;
+    *p = 0;
+    do *--p = '0' + v % 10; while (v /= 10);
+    if (n < 0) *--p = '-';
+    return p;
+  }
+  static char *formatDouble(NUMBERTEXT &text, double d){ //the shortest text that reads back as d; NaN and Infinity as javascript has them
+    if (d - d != 0) return strcpy(text, d != d ? "NaN" : d < 0 ? "-Infinity" : "Infinity");
+    static const double powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    double a = d < 0 ? -d : d;
+    for (int places = 0; a < 1e9 && places <= 6; places++){ //a few decimal places, as most settings have, need no printf
+      unsigned long long v = a * powers[places] + 0.5;
+      if (v / powers[places] != a) continue; //the fewest places that read back as d
+      char *p = text + sizeof text - 1;
+      *p = 0;
+      for (int i = 0; i < places; i++, v /= 10) *--p = '0' + v % 10;
+      if (places) *--p = '.';
+      do *--p = '0' + v % 10; while (v /= 10);
+      if (d < 0) *--p = '-';
+      return p;
+    }
+    for (int digits = 15;; digits++){ //15 digits give any shorter decimal back exactly, 17 any double
+      snprintf(text, sizeof text, "%.*g", digits, d);
+      if (digits == 17 || strtod(text, nullptr) == d) return text;
+    }
+  }
+
+
+  enum FIELDFLAGS : uint8_t { FIELD_PRIVATE = 1, FIELD_READONLY = 2, FIELD_NOREAD = 4, FIELD_NOWRITE = 8, FIELD_VOLATILE = 16, FIELD_CONST = 32 };
+  template <typename Visitor> void visitFields(Visitor &&visit){ //visit(name, path, member, flags) for each field
+    visit("version", "version", this->version, FIELD_READONLY | FIELD_CONST);
+    visit("filename", "filename", this->filename, FIELD_PRIVATE | FIELD_READONLY | FIELD_CONST);
+    visit("name", "name", this->name, 0);
+    visit("count", "count", this->count, 0);
+    visit("enabled", "enabled", this->enabled, 0);
+    visit("ratio", "ratio", this->ratio, 0);
+    visit("ssid", "network.ssid", this->network.ssid, 0);
+    visit("port", "network.port", this->network.port, 0);
+    visit("address", "network.address", this->network.address, 0);
+  }//visitFields
+
+  template <typename Visitor> void visitFields(Visitor &&visit) const{ //<LAZY> objects as loaded so far
+    visit("version", "version", this->version, FIELD_READONLY | FIELD_CONST);
+    visit("filename", "filename", this->filename, FIELD_PRIVATE | FIELD_READONLY | FIELD_CONST);
+    visit("name", "name", this->name, 0);
+    visit("count", "count", this->count, 0);
+    visit("enabled", "enabled", this->enabled, 0);
+    visit("ratio", "ratio", this->ratio, 0);
+    visit("ssid", "network.ssid", this->network.ssid, 0);
+    visit("port", "network.port", this->network.port, 0);
+    visit("address", "network.address", this->network.address, 0);
+  }//visitFields
+
+
+  static uint32_t fingerprintOf(uint32_t h, const void *p, size_t n){
+    for (const uint8_t *b = (const uint8_t *)p; n--; b++) h = (h ^ *b) * 16777619u;
+    return h;
+  }
+  template <class T> static uint32_t fingerprintOf(uint32_t h, const T &v){ return fingerprintOf(h, &v, sizeof v); }
+  template <size_t N> static uint32_t fingerprintOf(uint32_t h, const char (&s)[N]){ return fingerprintOf(h, s, strnlen(s, N - 1) + 1); }
+  static uint32_t fingerprintOf(uint32_t h, const String &s){ return fingerprintOf(h, s.c_str(), s.length() + 1); }
+  static uint32_t fingerprintOf(uint32_t h, double d){
+    if (d != d) return fingerprintOf(h, (uint64_t)0x7FF8000000000000u); //every NaN as the one quiet NaN
+    if (d == 0) d = 0; //-0.0 as 0.0
+    return fingerprintOf(h, &d, sizeof d);
+  }
+  static bool sameValue(double a, double b){ return a == b || (a != a && b != b); } //NaN is NaN, so a copy equals its original
+  uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+    h = fingerprintOf(h, this->name);
+    h = fingerprintOf(h, this->count);
+    h = fingerprintOf(h, this->enabled);
+    h = fingerprintOf(h, this->ratio);
+    h = this->network.fingerprint(h);
+    return h;
+  }
+  bool operator==(const SETTINGS &o) const{ //the persisted fields are equal
+    return this->name == o.name && this->count == o.count && this->enabled == o.enabled && sameValue(this->ratio, o.ratio) && this->network == o.network;
+  }
+  bool operator!=(const SETTINGS &o) const{ return !(*this == o); }
+
+
+  static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0){ //crc is that of the bytes before p, if any
+    static const uint32_t nibbles[16] = {
+      0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+      0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu};
+    crc = ~crc;
+    while (n--){
+      crc = nibbles[(crc ^ *p) & 0x0F] ^ (crc >> 4);
+      crc = nibbles[(crc ^ (*p++ >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+  }//crc32
+
+#ifdef Arduino_h
+  static uint8_t *loadBytes(const char *f, size_t &n, size_t limit = (size_t)-1, size_t offset = 0){
+    recoverFile(f);
+    File file = SPIFFS.open(f, "r");
+    if (!file || file.size() < offset || !file.seek(offset, SeekSet)) return nullptr;
+    n = min((size_t)file.size() - offset, limit);
+    uint8_t *buf = (uint8_t *)malloc(n + 1);
+    if (buf && file.read(buf, n) != n){
+      free(buf);
+      buf = nullptr;
+    }
+    if (buf) buf[n] = 0;
+    file.close();
+    return buf;
+  }//loadBytes
+
+  static bool saveBytes(const char *f, const uint8_t *buf, size_t n, const char *mode = "w"){
+    //a whole file is written to a temporary file first; SPIFFS won't rename over f, so it is removed just before the rename
+    String temp = *mode == 'a' ? String(f) : String(f) + ".tmp";
+    File file = SPIFFS.open(temp, mode);
+    if (!file) return false;
+    bool ok = file.write(buf, n) == n;
+    file.close();
+    if (*mode == 'a') return ok;
+    if (!ok){
+      SPIFFS.remove(temp);
+      return false;
+    }
+    return removeFile(f) && SPIFFS.rename(temp, f);
+  }//saveBytes
+
+  static void recoverFile(const char *f){ //a power cut between saveBytes() removing f and renaming its replacement leaves just the replacement
+    String temp = String(f) + ".tmp";
+    if (!SPIFFS.exists(f) && SPIFFS.exists(temp)) SPIFFS.rename(temp, f);
+  }
+
+  static bool removeFile(const char *f){
+    return !SPIFFS.exists(f) || SPIFFS.remove(f);
+  }
+#else
+  static uint8_t *loadBytes(const char *f, size_t &n, size_t limit = (size_t)-1, size_t offset = 0){
+    ifstream file(f, ios::binary | ios::ate);
+    if (!file || (size_t)file.tellg() < offset) return nullptr;
+    n = min((size_t)file.tellg() - offset, limit);
+    file.seekg(offset);
+    uint8_t *buf = (uint8_t *)malloc(n + 1);
+    if (buf && !file.read((char *)buf, n)){
+      free(buf);
+      buf = nullptr;
+    }
+    if (buf) buf[n] = 0;
+    return buf;
+  }//loadBytes
+
+  static bool saveBytes(const char *f, const uint8_t *buf, size_t n, const char *mode = "w"){
+    if (*mode == 'a'){
+      ofstream file(f, ios::binary | ios::app);
+      file.write((const char *)buf, n);
+      file.close();
+      return !file.fail();
+    }
+    //write a temporary file and rename it over f; f is always either the old or the new version
+    string temp = string(f) + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(buf, 1, n, file) == n && !fflush(file) && !fsync(fileno(file));
+    ok = !fclose(file) && ok && !rename(temp.c_str(), f);
+    if (!ok){
+      ::remove(temp.c_str());
+      return false;
+    }
+    string directory(f);
+    directory = directory.substr(0, directory.find_last_of('/') + 1);
+    int d = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (d >= 0){
+      fsync(d); //make the rename itself durable
+      close(d);
+    }
+    return true;
+  }//saveBytes
+
+  static void recoverFile(const char *){} //rename() replaces f in one step, so there is nothing to recover
+
+  static bool removeFile(const char *f){
+    return !::remove(f) || errno == ENOENT;
+  }
+#endif
+
+  template <class T> static uint8_t *binPut(uint8_t *p, const T &v){
+    memcpy(p, &v, sizeof v);
+    return p + sizeof v;
+  }
+  static uint8_t *binPut(uint8_t *p, const String &s){
+    uint16_t n = s.length();
+    memcpy(p, &n, 2);
+    memcpy(p + 2, s.c_str(), n + 1);
+    return p + n + 3;
+  }
+  template <class T> static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, T &v){
+    if (!p || p + sizeof v > end) return nullptr;
+    memcpy(&v, p, sizeof v);
+    return p + sizeof v;
+  }
+  static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, String &s){
+    uint16_t n;
+    if (!(p = binGet(p, end, n)) || p + n >= end || p[n]) return nullptr;
+    s = (const char *)p;
+    return p + n + 1;
+  }
+  template <class T> static size_t binSize(const T &v){
+    return sizeof v;
+  }
+  static size_t binSize(const String &s){
+    return s.length() + 3;
+  }
+  template <size_t N> static uint8_t *binPut(uint8_t *p, const char (&s)[N]){
+    uint16_t n = strlen(s);
+    memcpy(p, &n, 2);
+    memcpy(p + 2, s, n + 1);
+    return p + n + 3;
+  }
+  template <size_t N> static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, char (&s)[N]){
+    uint16_t n;
+    if (!(p = binGet(p, end, n)) || n >= N || p + n >= end || p[n]) return nullptr;
+    memcpy(s, p, n + 1);
+    return p + n + 1;
+  }
+  template <size_t N> static size_t binSize(const char (&s)[N]){
+    return strlen(s) + 3;
+  }
+
+
+#ifdef Arduino_h
+  class BLOCKREADER : public Stream { //a settings file read READ_BUF_SIZE bytes at a time
+    File file;
+    uint8_t block[READ_BUF_SIZE];
+    size_t next = 0, end = 0;
+    bool fill(){ //false at the end of the file
+      if (this->next < this->end) return true;
+      this->next = 0;
+      this->end = this->file ? this->file.read(this->block, sizeof this->block) : 0;
+      return this->end > 0;
+    }
+  public:
+    BLOCKREADER(File f) : file(f) {}
+    operator bool() const { return this->file; }
+    void close(){ this->file.close(); }
+    int available(){ return this->end - this->next + (this->file ? this->file.available() : 0); }
+    int read(){ return this->fill() ? this->block[this->next++] : -1; }
+    int peek(){ return this->fill() ? this->block[this->next] : -1; }
+    size_t readBytes(char *buffer, size_t length){ //what ArduinoJson calls, for a character at a time
+      size_t n = 0;
+      while (n < length && this->fill()){
+        size_t chunk = length - n < this->end - this->next ? length - n : this->end - this->next;
+        memcpy(buffer + n, this->block + this->next, chunk);
+        this->next += chunk;
+        n += chunk;
+      }
+      return n;
+    }
+    size_t write(uint8_t){ return 0; }
+    template <typename JSONBUFFER> JsonObject &parseObject(JSONBUFFER &jb){ return jb.parseObject((Stream &)*this); }
+  };
+#else
+  //the parser reads a mapped file as text, with no istream::get() a character; the page's slack past the end is the terminating 0
+  struct BLOCKS : streambuf { //a settings file mapped into memory, or failing that read READ_BUF_SIZE bytes at a time
+    int fd = -1;
+    char *mapped = nullptr;
+    size_t length = 0;
+    char block[READ_BUF_SIZE];
+    bool open(const char *f){
+      struct stat s;
+      if ((this->fd = ::open(f, O_RDONLY)) < 0) return false;
+      if (fstat(this->fd, &s) || s.st_size <= 0 || s.st_size % sysconf(_SC_PAGESIZE) == 0) return true; //read() it instead
+      void *p = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+      if (p == MAP_FAILED) return true;
+      this->mapped = (char *)p;
+      this->length = s.st_size;
+      setg(this->mapped, this->mapped, this->mapped + this->length);
+      return true;
+    }
+    void close(){
+      if (this->mapped) munmap(this->mapped, this->length);
+      if (this->fd >= 0) ::close(this->fd);
+      this->mapped = nullptr;
+      this->fd = -1;
+      setg(nullptr, nullptr, nullptr);
+    }
+    int_type underflow(){ //only when the file isn't mapped
+      ssize_t n = this->mapped || this->fd < 0 ? 0 : ::read(this->fd, this->block, sizeof this->block);
+      if (n <= 0) return traits_type::eof();
+      setg(this->block, this->block, this->block + n);
+      return traits_type::to_int_type(*gptr());
+    }
+  };
+  struct BLOCKSBASE { //a base of BLOCKREADER ahead of istream, so blocks is built before istream is handed it
+    BLOCKS blocks;
+  };
+  class BLOCKREADER : private BLOCKSBASE, public istream {
+  public:
+    BLOCKREADER(const char *f) : BLOCKSBASE(), istream(&this->blocks) {
+      if (!this->blocks.open(f)) setstate(ios::failbit);
+    }
+    void close(){ this->blocks.close(); }
+    ~BLOCKREADER(){ this->blocks.close(); }
+    template <typename JSONBUFFER> JsonObject &parseObject(JSONBUFFER &jb){ //strings are copied into jb, so nothing points into the mapping
+      return this->blocks.mapped ? jb.parseObject((const char *)this->blocks.mapped) : jb.parseObject((istream &)*this);
+    }
+  };
+#endif
+
+
+  size_t journalBytes = (size_t)-1; //journal file size; (size_t)-1 if read() hasn't checked it or found it damaged
+
+  String journalFilename(){
+    return String(this->filename) + ".jnl";
+  }
+
+  template <class T> static uint8_t *journalPut(uint8_t *p, uint16_t id, const T &v){
+    uint8_t *record = p;
+    p = binPut(p, id);
+    p = binPut(p, (uint16_t)binSize(v));
+    p = binPut(p, v);
+    return binPut(p, crc32(record, p - record));
+  }
+
+  bool writeDirty() { //only what the setters changed
+    if (this->journalBytes == (size_t)-1 || !this->appendJournal(false)) return this->write();
+    this->clearDirty();
+    return this->journalBytes <= JOURNAL_COMPACT_BYTES || this->write();
+  }//writeDirty
+
+  bool appendJournal(bool everything){ //a record per dirty field, or per field
+    size_t n = 0;
+    if (everything || this->dirty[0] & 1u << 0) n += 8 + binSize(this->name);
+    if (everything || this->dirty[0] & 1u << 1) n += 8 + binSize(this->count);
+    if (everything || this->dirty[0] & 1u << 2) n += 8 + binSize(this->enabled);
+    if (everything || this->dirty[0] & 1u << 3) n += 8 + binSize(this->ratio);
+    if (everything || this->dirty[0] & 1u << 4) n += 8 + binSize(this->network.ssid);
+    if (everything || this->dirty[0] & 1u << 5) n += 8 + binSize(this->network.port);
+    if (everything || this->dirty[0] & 1u << 6) n += 8 + binSize(this->network.address);
+    if (!n) return true;
+    if (!this->journalBytes) n += 8;
+    uint8_t *buf = (uint8_t *)malloc(n);
+    if (!buf) return false;
+    uint8_t *p = buf;
+    if (!this->journalBytes){
+      memcpy(p, "J2SJ", 4);
+      p = binPut(p + 4, (uint32_t)(0xFE183CE6u ^ sizeof(long) << 8 ^ sizeof(double) << 16));
+    }
+    if (everything || this->dirty[0] & 1u << 0) p = journalPut(p, 0, this->name);
+    if (everything || this->dirty[0] & 1u << 1) p = journalPut(p, 1, this->count);
+    if (everything || this->dirty[0] & 1u << 2) p = journalPut(p, 2, this->enabled);
+    if (everything || this->dirty[0] & 1u << 3) p = journalPut(p, 3, this->ratio);
+    if (everything || this->dirty[0] & 1u << 4) p = journalPut(p, 4, this->network.ssid);
+    if (everything || this->dirty[0] & 1u << 5) p = journalPut(p, 5, this->network.port);
+    if (everything || this->dirty[0] & 1u << 6) p = journalPut(p, 6, this->network.address);
+    bool ok = saveBytes(journalFilename().c_str(), buf, n, "a");
+    free(buf);
+    if (ok) this->journalBytes += n;
+    return ok;
+  }//appendJournal
+
+  bool replayJournal(){ //true if every field was replayed
+    size_t n;
+    uint8_t *buf = loadBytes(journalFilename().c_str(), n);
+    this->journalBytes = 0;
+    if (!buf) return false;
+    this->journalBytes = n;
+    uint32_t replayed[1] = {0};
+    uint32_t schema = 0;
+    if (n >= 8 && !memcmp(buf, "J2SJ", 4)) memcpy(&schema, buf + 4, 4);
+    const uint8_t *p = buf + 8, *end = buf + n;
+    if (schema != (0xFE183CE6u ^ sizeof(long) << 8 ^ sizeof(double) << 16)) p = nullptr;
+    while (p && p < end){
+      uint16_t id, length;
+      uint32_t crc;
+      if (!binGet(binGet(p, end, id), end, length) || !binGet(p + 4 + length, end, crc) || crc != crc32(p, 4 + length)){
+        p = nullptr;
+        break;
+      }
+      const uint8_t *value = p + 4, *valueEnd = value + length;
+      switch (id){
+        case 0: value = binGet(value, valueEnd, this->name); break;
+        case 1: value = binGet(value, valueEnd, this->count); break;
+        case 2: value = binGet(value, valueEnd, this->enabled); break;
+        case 3: value = binGet(value, valueEnd, this->ratio); break;
+        case 4: value = binGet(value, valueEnd, this->network.ssid); break;
+        case 5: value = binGet(value, valueEnd, this->network.port); break;
+        case 6: value = binGet(value, valueEnd, this->network.address); break;
+        default: value = nullptr;
+      }
+      p = value == valueEnd ? valueEnd + 4 : nullptr;
+      if (p) replayed[id / 32] |= 1u << id % 32;
+    }
+    if (!p) this->journalBytes = (size_t)-1; //damaged or from another version
+    free(buf);
+    return (replayed[0] & 0x0000007Fu) == 0x0000007Fu;
+  }//replayJournal
+
+
+  uint32_t dirty[1] = {0}; //a bit per persisted field, in struct order
+
+  bool isDirty() const {
+    for (uint32_t bits : this->dirty) if (bits) return true;
+    return false;
+  }
+  void clearDirty(){
+    memset(this->dirty, 0, sizeof this->dirty);
+  }
+  bool writeIfDirty(){ //skip the write altogether if nothing has changed
+    return !this->isDirty() || this->writeDirty(); //appended to the journal
+  }
+  void setName(const String &v){
+    if (this->name == v) return;
+    this->name = v;
+    this->dirty[0] |= 1u << 0;
+  }
+  void setCount(long v){
+    if (this->count == v) return;
+    this->count = v;
+    this->dirty[0] |= 1u << 1;
+  }
+  void setEnabled(bool v){
+    if (this->enabled == v) return;
+    this->enabled = v;
+    this->dirty[0] |= 1u << 2;
+  }
+  void setRatio(double v){
+    if (this->ratio == v) return;
+    this->ratio = v;
+    this->dirty[0] |= 1u << 3;
+  }
+  void setNetworkSsid(const char *v){
+    if (!setText(this->network.ssid, v)) return;
+    this->dirty[0] |= 1u << 4;
+  }
+  void setNetworkPort(uint16_t v){
+    if (this->network.port == v) return;
+    this->network.port = v;
+    this->dirty[0] |= 1u << 5;
+  }
+  void setNetworkAddress(uint32_t v){
+    if (this->network.address == v) return;
+    this->network.address = v;
+    this->dirty[0] |= 1u << 6;
+  }
+
+  String getValuesScript(){
+    String retval = "";
+    NUMBERTEXT number;
+    retval += String("var values = {};") + "\n";
+    retval += String("values['version'] = ") + "'" + this->version + "'" + ";\n";
+    retval += String("values['name'] = ") + "'" + this->name + "'" + ";\n";
+    retval += String("values['count'] = ") + formatLong(number, this->count) + ";\n";
+    retval += String("document.getElementById('enabled').checked = ") + (this->enabled ? "true" : "false") + ";\n";
+    retval += String("values['ratio'] = ") + formatDouble(number, this->ratio) + ";\n";
+    retval += String("values['network.ssid'] = ") + "'" + this->network.ssid + "'" + ";\n";
+    retval += String("values['network.port'] = ") + formatLong(number, this->network.port) + ";\n";
+    retval += String("values['network.address'] = ") + "'" + formatIpv4(this->network.address) + "'" + ";\n";
+
+    retval += "for (var key in values) {";
+    retval += "  document.getElementById(key).value = values[key];";
+    retval += "}";
+    return retval;
+  }//getValuesScript
+
+} settings;
+constexpr char SETTINGS::version[];
+constexpr char SETTINGS::filename[];
+
@@ -0,0 +1,354 @@
+// Generated on 19Oct26 10:03.
+
+#pragma once
+
+
+#ifdef Arduino_h
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#define JSON_BUF_SIZE 3000
+
+#define OUT(f)\
+    File settingsFile = SPIFFS.open(f, "w");\
+    root.prettyPrintTo(settingsFile);\
+    settingsFile.close();
+    
+#ifndef READ_BUF_SIZE
+#define READ_BUF_SIZE 256 //bytes read() takes from the settings file at a time; a SPIFFS page
+#endif
+#define IN(f)\
+    BLOCKREADER settingsFile(SPIFFS.open(f, "r"));
+
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "ArduinoJson-v5.13.4.h"
+
+#define String string
+#define JSON_BUF_SIZE 3000
+
+#define OUT(f)\
+    string buf;\
+    root.prettyPrintTo(buf);\
+    ofstream settingsFile(f);\
+    settingsFile << buf;\
+    settingsFile.close();
+#ifndef READ_BUF_SIZE
+#define READ_BUF_SIZE 4096 //bytes read() takes from the settings file at a time, when it can't be mapped
+#endif
+#define IN(f)\
+    BLOCKREADER settingsFile(String(f).c_str());
+#endif
+
+#define READ_OK 0
+#define READ_PARSE_FAIL 1
+#define READ_VERSION_NO_MATCH 2
+#define READ_FILE_NOT_FOUND 3
+
+using namespace std;
+
+struct SETTINGS{
+  static constexpr char version[] = "1.0";
+  static constexpr char filename[] = "settings.json";
+  String name = "journal";
+  long count = 0;
+  bool enabled = true;
+  double ratio = 0.5;
+  struct NETWORK {
+    char ssid[33] = "MY_SSID";
+    uint16_t port = 80;
+    uint32_t address = 0x0104A8C0u;
+    uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+      h = fingerprintOf(h, this->ssid);
+      h = fingerprintOf(h, this->port);
+      h = fingerprintOf(h, this->address);
+      return h;
+    }
+    bool operator==(const NETWORK &o) const{ //the persisted fields are equal
+      return !strcmp(this->ssid, o.ssid) && this->port == o.port && this->address == o.address;
+    }
+    bool operator!=(const NETWORK &o) const{ return !(*this == o); }
+  }network;
+
+  bool write() {
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    JsonObject &root = jb.createObject();
+    root["version"] = this->version;
+    root["name"] = this->name;
+    root["count"] = this->count;
+    root["enabled"] = this->enabled;
+    root["ratio"] = this->ratio;
+    root.createNestedObject("network");
+    root["network"]["ssid"] = this->network.ssid;
+    root["network"]["port"] = this->network.port;
+    root["network"]["address"] = formatIpv4(this->network.address);
+
+    OUT(this->filename);
+    return true;
+  }//write
+
+  int read() {
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    IN(this->filename);
+    if (!settingsFile) return READ_FILE_NOT_FOUND;
+    JsonObject &root = settingsFile.parseObject(jb);
+    if (!root.success()) return READ_PARSE_FAIL;
+    if (strcmp(this->version, root["version"] | "")) return READ_VERSION_NO_MATCH;
+    this->name = root["name"].as<char*>();
+    this->count = root["count"].as<long>();
+    this->enabled = root["enabled"].as<bool>();
+    this->ratio = root["ratio"].as<double>();
+    setText(this->network.ssid, root["network"]["ssid"].as<const char*>());
+    readInteger(this->network.port, root["network"]["port"], 0, 65535);
+    readIpv4(this->network.address, root["network"]["address"]);
+
+    settingsFile.close();
+    return READ_OK;
+  }//read
+
+  template <size_t N> static bool setText(char (&to)[N], const char *from){
+    if (!from) from = "";
+    size_t n = strnlen(from, N - 1);
+    if (!strncmp(to, from, n) && !to[n]) return false;
+    memcpy(to, from, n);
+    to[n] = 0;
+    return true;
+  }
+
+
+  template <class T> static void readInteger(T &x, JsonVariant v, long minValue, long maxValue){
+    long n = v.as<long>(); //numbers, or numeric strings from before the field was narrowed
+    x = n < minValue ? minValue : n > maxValue ? maxValue : n;
+  }
+  static bool parseInteger(const char *s, long minValue, long maxValue, long &n){
+    char *end;
+    n = strtol(s, &end, 10);
+    return end != s && !*end && n >= minValue && n <= maxValue;
+  }
+
+
+  static bool parseIpv4(const char *s, uint32_t &ip){ //"a.b.c.d", a in the low byte as in IPAddress; "" is 0
+    if (!*s) return ip = 0, true;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++){
+      unsigned octet = 0, digits = 0;
+      while (*s >= '0' && *s <= '9' && digits++ < 3) octet = octet * 10 + (*s++ - '0');
+      if (!digits || octet > 255 || *s != (i < 3 ? '.' : '\0')) return false;
+      if (i < 3) s++;
+      v |= (uint32_t)octet << (8 * i);
+    }
+    ip = v;
+    return true;
+  }
+  static char *formatIpv4(uint32_t ip){ //into a buffer shared by every call, so use the text straight away; 0 is ""
+    static char text[16];
+    char *p = text;
+    for (int i = 0; i < 4 && (ip || i); i++, ip >>= 8){
+      uint8_t octet = ip;
+      if (octet >= 100) *p++ = '0' + octet / 100;
+      if (octet >= 10) *p++ = '0' + octet / 10 % 10;
+      *p++ = '0' + octet % 10;
+      if (i < 3) *p++ = '.';
+    }
+    *p = 0;
+    return text;
+  }
+  static void readIpv4(uint32_t &x, JsonVariant v){
+    const char *s = v.as<const char *>();
+    if (!s || !parseIpv4(s, x)) x = 0;
+  }
+
+
+  typedef char NUMBERTEXT[26]; //room for any long or double as text
+  static char *formatLong(NUMBERTEXT &text, long n){ //returns the first character, somewhere in text
+    char *p = text + sizeof text - 1;
+    unsigned long v = n < 0 ? 0ul - n : n;
+    *p = 0;
+    do *--p = '0' + v % 10; while (v /= 10);
+    if (n < 0) *--p = '-';
+    return p;
+  }
+  static char *formatDouble(NUMBERTEXT &text, double d){ //the shortest text that reads back as d; NaN and Infinity as javascript has them
+    if (d - d != 0) return strcpy(text, d != d ? "NaN" : d < 0 ? "-Infinity" : "Infinity");
+    static const double powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    double a = d < 0 ? -d : d;
+    for (int places = 0; a < 1e9 && places <= 6; places++){ //a few decimal places, as most settings have, need no printf
+      unsigned long long v = a * powers[places] + 0.5;
+      if (v / powers[places] != a) continue; //the fewest places that read back as d
+      char *p = text + sizeof text - 1;
+      *p = 0;
+      for (int i = 0; i < places; i++, v /= 10) *--p = '0' + v % 10;
+      if (places) *--p = '.';
+      do *--p = '0' + v % 10; while (v /= 10);
+      if (d < 0) *--p = '-';
+      return p;
+    }
+    for (int digits = 15;; digits++){ //15 digits give any shorter decimal back exactly, 17 any double
+      snprintf(text, sizeof text, "%.*g", digits, d);
+      if (digits == 17 || strtod(text, nullptr) == d) return text;
+    }
+  }
+
+
+  enum FIELDFLAGS : uint8_t { FIELD_PRIVATE = 1, FIELD_READONLY = 2, FIELD_NOREAD = 4, FIELD_NOWRITE = 8, FIELD_VOLATILE = 16, FIELD_CONST = 32 };
+  template <typename Visitor> void visitFields(Visitor &&visit){ //visit(name, path, member, flags) for each field
+    visit("version", "version", this->version, FIELD_READONLY | FIELD_CONST);
+    visit("filename", "filename", this->filename, FIELD_PRIVATE | FIELD_READONLY | FIELD_CONST);
+    visit("name", "name", this->name, 0);
+    visit("count", "count", this->count, 0);
+    visit("enabled", "enabled", this->enabled, 0);
+    visit("ratio", "ratio", this->ratio, 0);
+    visit("ssid", "network.ssid", this->network.ssid, 0);
+    visit("port", "network.port", this->network.port, 0);
+    visit("address", "network.address", this->network.address, 0);
+  }//visitFields
+
+  template <typename Visitor> void visitFields(Visitor &&visit) const{ //<LAZY> objects as loaded so far
+    visit("version", "version", this->version, FIELD_READONLY | FIELD_CONST);
+    visit("filename", "filename", this->filename, FIELD_PRIVATE | FIELD_READONLY | FIELD_CONST);
+    visit("name", "name", this->name, 0);
+    visit("count", "count", this->count, 0);
+    visit("enabled", "enabled", this->enabled, 0);
+    visit("ratio", "ratio", this->ratio, 0);
+    visit("ssid", "network.ssid", this->network.ssid, 0);
+    visit("port", "network.port", this->network.port, 0);
+    visit("address", "network.address", this->network.address, 0);
+  }//visitFields
+
+
+  static uint32_t fingerprintOf(uint32_t h, const void *p, size_t n){
+    for (const uint8_t *b = (const uint8_t *)p; n--; b++) h = (h ^ *b) * 16777619u;
+    return h;
+  }
+  template <class T> static uint32_t fingerprintOf(uint32_t h, const T &v){ return fingerprintOf(h, &v, sizeof v); }
+  template <size_t N> static uint32_t fingerprintOf(uint32_t h, const char (&s)[N]){ return fingerprintOf(h, s, strnlen(s, N - 1) + 1); }
+  static uint32_t fingerprintOf(uint32_t h, const String &s){ return fingerprintOf(h, s.c_str(), s.length() + 1); }
+  static uint32_t fingerprintOf(uint32_t h, double d){
+    if (d != d) return fingerprintOf(h, (uint64_t)0x7FF8000000000000u); //every NaN as the one quiet NaN
+    if (d == 0) d = 0; //-0.0 as 0.0
+    return fingerprintOf(h, &d, sizeof d);
+  }
+  static bool sameValue(double a, double b){ return a == b || (a != a && b != b); } //NaN is NaN, so a copy equals its original
+  uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded
+    h = fingerprintOf(h, this->name);
+    h = fingerprintOf(h, this->count);
+    h = fingerprintOf(h, this->enabled);
+    h = fingerprintOf(h, this->ratio);
+    h = this->network.fingerprint(h);
+    return h;
+  }
+  bool operator==(const SETTINGS &o) const{ //the persisted fields are equal
+    return this->name == o.name && this->count == o.count && this->enabled == o.enabled && sameValue(this->ratio, o.ratio) && this->network == o.network;
+  }
+  bool operator!=(const SETTINGS &o) const{ return !(*this == o); }
+
+
+#ifdef Arduino_h
+  class BLOCKREADER : public Stream { //a settings file read READ_BUF_SIZE bytes at a time
+    File file;
+    uint8_t block[READ_BUF_SIZE];
+    size_t next = 0, end = 0;
+    bool fill(){ //false at the end of the file
+      if (this->next < this->end) return true;
+      this->next = 0;
+      this->end = this->file ? this->file.read(this->block, sizeof this->block) : 0;
+      return this->end > 0;
+    }
+  public:
+    BLOCKREADER(File f) : file(f) {}
+    operator bool() const { return this->file; }
+    void close(){ this->file.close(); }
+    int available(){ return this->end - this->next + (this->file ? this->file.available() : 0); }
+    int read(){ return this->fill() ? this->block[this->next++] : -1; }
+    int peek(){ return this->fill() ? this->block[this->next] : -1; }
+    size_t readBytes(char *buffer, size_t length){ //what ArduinoJson calls, for a character at a time
+      size_t n = 0;
+      while (n < length && this->fill()){
+        size_t chunk = length - n < this->end - this->next ? length - n : this->end - this->next;
+        memcpy(buffer + n, this->block + this->next, chunk);
+        this->next += chunk;
+        n += chunk;
+      }
+      return n;
+    }
+    size_t write(uint8_t){ return 0; }
+    template <typename JSONBUFFER> JsonObject &parseObject(JSONBUFFER &jb){ return jb.parseObject((Stream &)*this); }
+  };
+#else
+  //the parser reads a mapped file as text, with no istream::get() a character; the page's slack past the end is the terminating 0
+  struct BLOCKS : streambuf { //a settings file mapped into memory, or failing that read READ_BUF_SIZE bytes at a time
+    int fd = -1;
+    char *mapped = nullptr;
+    size_t length = 0;
+    char block[READ_BUF_SIZE];
+    bool open(const char *f){
+      struct stat s;
+      if ((this->fd = ::open(f, O_RDONLY)) < 0) return false;
+      if (fstat(this->fd, &s) || s.st_size <= 0 || s.st_size % sysconf(_SC_PAGESIZE) == 0) return true; //read() it instead
+      void *p = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+      if (p == MAP_FAILED) return true;
+      this->mapped = (char *)p;
+      this->length = s.st_size;
+      setg(this->mapped, this->mapped, this->mapped + this->length);
+      return true;
+    }
+    void close(){
+      if (this->mapped) munmap(this->mapped, this->length);
+      if (this->fd >= 0) ::close(this->fd);
+      this->mapped = nullptr;
+      this->fd = -1;
+      setg(nullptr, nullptr, nullptr);
+    }
+    int_type underflow(){ //only when the file isn't mapped
+      ssize_t n = this->mapped || this->fd < 0 ? 0 : ::read(this->fd, this->block, sizeof this->block);
+      if (n <= 0) return traits_type::eof();
+      setg(this->block, this->block, this->block + n);
+      return traits_type::to_int_type(*gptr());
+    }
+  };
+  struct BLOCKSBASE { //a base of BLOCKREADER ahead of istream, so blocks is built before istream is handed it
+    BLOCKS blocks;
+  };
+  class BLOCKREADER : private BLOCKSBASE, public istream {
+  public:
+    BLOCKREADER(const char *f) : BLOCKSBASE(), istream(&this->blocks) {
+      if (!this->blocks.open(f)) setstate(ios::failbit);
+    }
+    void close(){ this->blocks.close(); }
+    ~BLOCKREADER(){ this->blocks.close(); }
+    template <typename JSONBUFFER> JsonObject &parseObject(JSONBUFFER &jb){ //strings are copied into jb, so nothing points into the mapping
+      return this->blocks.mapped ? jb.parseObject((const char *)this->blocks.mapped) : jb.parseObject((istream &)*this);
+    }
+  };
+#endif
+
+  String getValuesScript(){
+    String retval = "";
+    NUMBERTEXT number;
+    retval += String("var values = {};") + "\n";
+    retval += String("values['version'] = ") + "'" + this->version + "'" + ";\n";
+    retval += String("values['name'] = ") + "'" + this->name + "'" + ";\n";
+    retval += String("values['count'] = ") + formatLong(number, this->count) + ";\n";
+    retval += String("document.getElementById('enabled').checked = ") + (this->enabled ? "true" : "false") + ";\n";
+    retval += String("values['ratio'] = ") + formatDouble(number, this->ratio) + ";\n";
+    retval += String("values['network.ssid'] = ") + "'" + this->network.ssid + "'" + ";\n";
+    retval += String("values['network.port'] = ") + formatLong(number, this->network.port) + ";\n";
+    retval += String("values['network.address'] = ") + "'" + formatIpv4(this->network.address) + "'" + ";\n";
+
+    retval += "for (var key in values) {";
+    retval += "  document.getElementById(key).value = values[key];";
+    retval += "}";
+    return retval;
+  }//getValuesScript
+
+} settings;
+constexpr char SETTINGS::version[];
+constexpr char SETTINGS::filename[];
+
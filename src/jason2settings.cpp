@@ -16,11 +16,117 @@
  *    Fields with comments that include the tag "<PRIVATE>" will appear in the header file but not as a field in the form file.
  *    Children of fields with comments that include the tag "<PRIVATE>" will appear in the header file but not as a field in the form file.
  * 
+ *    Fields with comments that include the tag "<VOLATILE>" (and children of objects so tagged) are runtime only: they appear in the header file and the
+ *    form file but are never read or written.
+ * 
+ *    Strings with comments that include the tag "<MAXLEN n>" (and strings in objects so tagged) are kept in a char[n + 1] instead of a String, so they
+ *    need no heap; longer values are truncated and the html form's maxlength becomes n. "<MAXLEN>" alone means 60, as the form.
+ * 
+ *    Integers with comments that include the tag "<U8>", "<I8>", "<U16>", "<I16>" or "<I32>" are kept in a uint8_t, int8_t... instead of a long;
+ *    "<RANGE a..b>" picks the narrowest type that holds a to b. read() clamps values to the range and submit() ignores values outside it.
+ *    A numeric string so tagged (eg: "port" : "80") becomes an integer.
+ * 
+ *    Numbers (and numeric strings) with comments that include the tag "<DECIMAL scale>" are kept in a long in units of 10^-scale (eg: 123.456 with
+ *    <DECIMAL 3> is 123456), so they are read, written and submitted exactly, without floating point.
+ * 
+ *    Strings with comments that include the tag "<IPV4>" are kept in a uint32_t, first octet in the low byte, ready for IPAddress. The settings file
+ *    and the form keep the dotted quad; "" is 0. read() takes a malformed address as 0 and submit() ignores it.
+ * 
+ *    Strings with comments that include the tag "<ENUM a|b|c>" are kept in an enum class declared with them (eg: enum class MODE : uint8_t { a, b, c })
+ *    and shown on the form as a select. The settings file keeps the name; enumName() gives it. read() and submit() ignore unknown names.
+ * 
+ *    Fields with comments that include the tag "<CONST>" are static constexpr members (a char[] for strings) instead of Strings, shown on the form
+ *    as <READONLY>. They are never read, nor written but for "version", which read() checks against the constant.
+ * 
+ *    Objects with comments that include the tag "<LAZY>" are skipped by read(), which only notes where they are in the settings file; each is parsed on first
+ *    use through its accessor (eg: getLocalServers()). Ignored with -j, but for the accessor, which then just returns the object.
+ * 
+ *    Objects with comments that include the tag "<FILE name>" (eg: <FILE /gasDiag.json>) are kept in a file of their own, with their own read and write
+ *    functions (eg: readGasDiagnostics(), writeGasDiagnostics()). read() and write() then cover all the files; the main one through readSettingsFile()
+ *    and writeSettingsFile(). Until its file exists, such an object is read from the settings file, or keeps its defaults.
+ * 
+ *    The header file's visitFields(visit) calls visit(name, path, member, flags) for each field in json order (eg: visit("name", "device.name",
+ *    settings.device.name, 0)), flags being FIELD_PRIVATE, FIELD_READONLY, FIELD_VOLATILE and FIELD_CONST or'd; a const overload visits a const struct.
+ * 
+ *    The settings struct, and each struct in it, has fingerprint(), a 32 bit FNV-1a hash of its persisted fields (not <VOLATILE>, not <CONST>)
+ *    taken in one pass without allocating, and operator== / operator!= comparing the same fields (doubles as values: -0.0 is 0.0, NaN is NaN),
+ *    so equal settings have equal fingerprints. On the settings struct these load any <LAZY>
+ *    objects first, so the result doesn't depend on which have been used; the const overloads, and the nested structs, take them as loaded so far.
+ * 
+ *    Objects of the same shape (the same members, types and defaults, in the same order) share the struct declared first; the others are declared
+ *    with a typedef of it. Where their statements are alike, they are read, written and added to the values script by functions of that struct,
+ *    readJson(), writeJson() and appendValues(). Shapes holding an <ENUM> or a <CONST> aren't shared.
+ * 
+ *    getValuesScript() formats numbers with formatLong() and formatDouble(), into a NUMBERTEXT the caller provides rather than a String of
+ *    their own (the script is still a String built up a field at a time);
+ *    a double as the shortest text that reads back the same (eg: 0.1, not 0.10). Checkboxes are set true or false.
+ * 
+ *    read() parses the settings file through a BLOCKREADER, READ_BUF_SIZE bytes (default 256, a SPIFFS page) at a time rather than a
+ *    character a call; on the host it maps the file into memory instead where it can. Ignored with -a or <LAZY> objects, which load the file whole.
+ * 
  * OPTIONS
  * 
  *    -f filename
  *        write an html form page to filename
  * 
+ *    -a
+ *        A/B slots: write() saves the json alternately to settings.filename + ".0" and ".1", each with a generation count and crc header.
+ *        read() loads the newest slot that checks out, so a power cut during write() leaves the previous settings readable.
+ * 
+ *    -b
+ *        add a packed binary copy of the settings (settings.filename + ".bin") to the header file.
+ *        read() tries the binary file first and falls back to json; write() updates both unless BIN_WRITE_POLICY is defined as BIN_WRITE_ONLY.
+ *        The binary file keeps the crc32 of the json file it was written with; if the json file has been changed or replaced since, read() parses it instead.
+ * 
+ *    -c filename
+ *        write the member functions (read(), write(), getValuesScript()...), the settings object and any tables to filename, a .cpp that includes
+ *        the header of the same name (eg: -c src/settings.cpp > src/settings.h). The header then only declares them, and the object is extern,
+ *        so it can be included by any number of files. Templates (submit(), visitFields()), static helpers and setters stay in the header.
+ * 
+ *    -d
+ *        add a setter per field (eg: setDeviceName()) that marks the field dirty when its value changes, plus isDirty(), clearDirty() and writeIfDirty().
+ *        read() and write() clear the dirty marks. submit() (see -s) uses the setters.
+ * 
+ *    -g
+ *        table driven: read(), write(), getValuesScript() and submit() loop over one constant table of the fields (in flash on the ESP) -
+ *        a row of name, offset, type and flags each - instead of having a statement per field, which saves flash as the fields grow.
+ *        The size of the table follows the struct; make flash-report compares the flash of both ways. submit() then finds each argument's
+ *        row with a strcmp_P a row rather than the perfect hash of -s. Not with -o; with -l the bools aren't packed into bitfields.
+ * 
+ *    -i
+ *        give integers without a width tag the narrowest type that holds their default (eg: 5 becomes a uint8_t, 60000 a uint16_t).
+ *        Only use it when the defaults are as big as the values will ever get.
+ * 
+ *    -j
+ *        journal mode (implies -d): writeDirty() (and writeIfDirty()) appends the fields changed through the setters to settings.filename
+ *        + ".jnl" instead of rewriting the settings file. read() replays the journal over the settings file. write() is still the full
+ *        write and compacts the journal into it, as writeDirty() does once the journal is bigger than JOURNAL_COMPACT_BYTES (default 1024).
+ *        The settings file is replaced whole, and a journal holding every field stands in for a settings file that is missing or damaged.
+ * 
+ *    -l
+ *        layout: declare the members of each struct most aligned first and pack the bools into bitfields, so no padding is needed between them.
+ *        The json key order of the settings file is unchanged. A layout report (sizes on the ESP8266) and static_asserts that the nested
+ *        structs are unpadded follow the struct.
+ * 
+ *    -m
+ *        memoize the values script: getValuesScript() keeps the script it made last, with a fingerprint of the fields shown on the form, and
+ *        returns it as it is until one of them changes. valuesScriptHits and valuesScriptMisses count the calls that did and didn't remake it.
+ * 
+ *    -o
+ *        sparse overrides: the defaults from the json specification are kept in a constant table (in flash on the ESP) and write() saves only
+ *        the fields that differ from them. read() gives any field missing from the settings file its default; resetToDefaults() restores them all.
+ * 
+ *    -s filename
+ *        write a snippet for handling the submitted html form to filename and add submit() to the header file.
+ *        submit() scans the request arguments once and maps each to its field with a (generated) perfect hash; with -g it looks each
+ *        one up in the field table instead, a strcmp_P a row, trading time for flash.
+ * 
+ *    -w
+ *        add a deferred write scheduler: requestWrite() notes that the settings need saving and service(nowMs), called from the main loop, writes
+ *        once WRITE_COALESCE_MS (default 2000) have passed since the first request and WRITE_MIN_INTERVAL_MS (default 30000) since its last write.
+ *        flushWrite() writes a pending request straight away. Any write() starts the minimum interval, timed by the next service() or
+ *        flushWrite(nowMs); requestWrite(nowMs) starts the coalescing at the request. writeRequests and scheduledWrites count requests and actual writes.
+ * 
  *    -t
  *        transfer json comments to header file
  * 
@@ -70,93 +176,2401 @@ char *htmlFormFilename = nullptr;
 // string valuesJsFilename = "data/valuesJs.js";  //<script src="myscripts.js"></script> HERE TODO FIXME when -v option is implemented
 bool makeSnippetFile = false; 
 char *snippetFilename = "src/snippets.txt"; //TODO
+bool makeImplementation = false; //the member functions are defined in a .cpp file of their own; the header only declares them
+char *implementationFilename = nullptr;
 string structureName = "settings";
 string structureLabel = "SETTINGS";
+bool makeBinary = false; //add a packed binary copy of the settings for fast reading
+bool trackDirty = false; //add setters that note which fields have changed since the last read() or write()
+bool makeJournal = false; //write() appends changed fields to a journal instead of rewriting the settings file
+bool makeSlots = false; //keep the settings file in two slots, written alternately, so a power cut can't lose it
+bool makeScheduler = false; //add requestWrite()/service() to coalesce writes
+bool makeOverrides = false; //keep the defaults in a flash table and write only the fields that differ from them
+bool makeLayout = false; //declare the struct members most aligned first and pack the bools into bitfields
+bool makeTable = false; //read, write, the values script and submit interpret a table of the fields instead of a statement per field
+bool cacheValuesScript = false; //getValuesScript() keeps the script it made and makes it again only once a field on the form has changed
+bool inferIntegers = false; //give unannotated integers the narrowest type that holds their default
+bool readInMemory = false; //IN() loads the whole settings file into a JSONTEXT (-a option and <LAZY> objects)
 bool transferComments = false; //weave json comments into header file
 bool insertTooltips = true; // weave comments as tooltips into html form fields
 string writeFunctionText = ""; //text for a function to write settings to file
 string readFunctionText = "";  //text for a function to read settings from a file
 string valuesFunctionText = "";  //text for a function to read settings from a file
+string pruneFunctionText = ""; //statements removing empty objects before a sparse write (-o option)
+string comparisonFunctionText = ""; //fingerprint() and operator== of the settings struct; the nested structs have their own
 string initValues = ""; //text for html initialisation 
 
-ofstream htmlOutput;
-ofstream valuesJs;
-ofstream snippetOutput;
+ofstream htmlOutput;
+ofstream valuesJs;
+ofstream snippetOutput;
+ofstream implementationOutput;
+
+map<string,vector<string>> commentsNew; // holds identifier/comment pairs - multiple comments per id are possible as ids are not unique if in different objects
+
+/**
+ * @brief One leaf setting, as collected by iterateObject(). Used to generate code that needs to see all the fields at once.
+ */
+struct FIELD {
+  string path;       // dotted name as used in the html form and struct eg: "device.wiFi.useMdns"
+  string type;       // "bool", "long", "double" or "String"
+  string value;      // default value from the json specification, as json text
+  bool isPrivate;    // <PRIVATE> or child of <PRIVATE>
+  bool isReadOnly;   // <READONLY> or child of <READONLY>
+  bool isVolatile;   // <VOLATILE> or child of <VOLATILE>: runtime only, never read or written
+  int file;          // index of the <FILE> subtree that holds the field, -1 if it is in the main settings file
+  int lazy;          // index of the <LAZY> object that holds the field, -1 if it is read by read()
+  int maxLength;     // <MAXLEN n> or child of <MAXLEN n>: a String kept in a char[maxLength + 1]; 0 for an Arduino String
+  long minValue;     // the range of a narrowed integer (<U8>, <RANGE a..b>, -i option...), checked by read() and submit();
+  long maxValue;     // both 0 for a long
+  int scale;         // <DECIMAL scale>: a number kept in a long in units of 10^-scale; 0 otherwise
+  bool isIpv4;       // <IPV4>: a dotted quad string kept in a uint32_t
+  vector<string> enumNames; // <ENUM a|b|c>: a string kept in an enum class (type) of these names, by index; empty otherwise
+  bool isConst;      // <CONST>: a static constexpr member, never read (nor written, but for the version)
+};
+vector<FIELD> fields;
+
+/**
+ * @brief Whether the field is read and written, ie: whether it has a slot in the binary file, the journal and the dirty bits.
+ */
+bool isPersisted(const FIELD& f){
+  return f.type != "// unknown type" && !f.isVolatile && !f.isConst;
+}
+
+bool hasConsts(){
+  for (const FIELD& f : fields) if (f.isConst) return true;
+  return false;
+}
+
+/**
+ * @brief Make the text of the definitions of the <CONST> fields, which C++11 needs once they are bound to a reference
+ * (eg: by root["version"] = ...). The header is only ever included once, as it defines the settings themselves.
+ */
+string makeConstDefinitionsText(){
+  string text;
+  for (const FIELD& f : fields){
+    if (!f.isConst) continue;
+    vector<string> keys;
+    boost::split(keys, f.path, boost::is_any_of("."));
+    string name = structureLabel;
+    for (size_t i = 0; i + 1 < keys.size(); i++) name += "::" + boost::to_upper_copy(keys[i]);
+    name += "::" + keys.back();
+    if (f.type == "String") text += "constexpr char " + name + "[];\n";
+    else text += "constexpr " + (f.enumNames.empty() ? f.type : structureLabel + "::" + f.type) + " " + name + ";\n";
+  }
+  return text;
+}
+
+/**
+ * @brief Whether the field is an integer narrower than long, ie: whether its values are range checked.
+ */
+bool isNarrowInteger(const FIELD& f){
+  return f.minValue != f.maxValue;
+}
+
+bool hasNarrowIntegers(){
+  for (const FIELD& f : fields) if (isNarrowInteger(f)) return true;
+  return false;
+}
+
+bool hasDecimals(){
+  for (const FIELD& f : fields) if (f.scale) return true;
+  return false;
+}
+
+bool hasIpv4s(){
+  for (const FIELD& f : fields) if (f.isIpv4) return true;
+  return false;
+}
+
+/**
+ * @brief The integer types a field can be narrowed to, narrowest first.
+ */
+struct INTEGERTYPE {
+  const char *name;
+  const char *tag;
+  long minValue;
+  long maxValue;
+  int size;
+};
+const INTEGERTYPE integerTypes[] = {
+  {"uint8_t", "<U8>", 0, 255, 1},
+  {"int8_t", "<I8>", -128, 127, 1},
+  {"uint16_t", "<U16>", 0, 65535, 2},
+  {"int16_t", "<I16>", -32768, 32767, 2},
+  {"int32_t", "<I32>", -2147483647L - 1, 2147483647L, 4},
+};
+
+/**
+ * @brief The narrowest type that holds every value from minValue to maxValue; nullptr if only a long will do.
+ */
+const INTEGERTYPE *narrowestType(long minValue, long maxValue){
+  for (const INTEGERTYPE& t : integerTypes) if (minValue >= t.minValue && maxValue <= t.maxValue) return &t;
+  return nullptr;
+}
+
+const INTEGERTYPE *integerType(const string& name){
+  for (const INTEGERTYPE& t : integerTypes) if (name == t.name) return &t;
+  return nullptr;
+}
+
+/**
+ * @brief The range of a narrowed integer as the arguments of the generated range checks eg: "0, 65535"
+ */
+string rangeText(long minValue, long maxValue){
+  string text = minValue == -2147483647L - 1 ? "-2147483647L - 1" : to_string(minValue); //the literal 2147483648 would be a long long
+  return text + ", " + to_string(maxValue);
+}
+
+string rangeText(const FIELD& f){
+  return rangeText(f.minValue, f.maxValue);
+}
+
+/**
+ * @brief Find an integer width tag (<U8>, <I8>, <U16>, <I16>, <I32> or <RANGE a..b>) in a comment, noting its range and removing it.
+ * @return whether there was one
+ */
+bool takeIntegerTag(string& comment, long& minValue, long& maxValue){
+  for (const INTEGERTYPE& t : integerTypes){
+    size_t tag = comment.find(t.tag);
+    if (tag == string::npos) continue;
+    comment.erase(tag, strlen(t.tag));
+    minValue = t.minValue;
+    maxValue = t.maxValue;
+    return true;
+  }
+  size_t tag = comment.find("<RANGE ");
+  if (tag == string::npos) return false;
+  size_t end = comment.find('>', tag);
+  string range = comment.substr(tag + 7, end == string::npos ? string::npos : end - tag - 7);
+  comment.erase(tag, end == string::npos ? string::npos : end + 1 - tag);
+  size_t dots = range.find("..");
+  if (dots == string::npos) return false;
+  minValue = atol(range.substr(0, dots).c_str());
+  maxValue = atol(range.substr(dots + 2).c_str());
+  return minValue < maxValue;
+}
+
+/**
+ * @brief Make the text of the range checked integer conversions used by read() and submit() for narrowed integers.
+ * read() clamps what it finds to the range; submit() ignores anything that isn't a whole number within it.
+ */
+string makeIntegerHelpersText(){
+  string text = R"(
+  template <class T> static void readInteger(T &x, JsonVariant v, long minValue, long maxValue){
+    long n = v.as<long>(); //numbers, or numeric strings from before the field was narrowed
+    x = n < minValue ? minValue : n > maxValue ? maxValue : n;
+  }
+  static bool parseInteger(const char *s, long minValue, long maxValue, long &n){
+    char *end;
+    n = strtol(s, &end, 10);
+    return end != s && !*end && n >= minValue && n <= maxValue;
+  }
+)";
+  if (makeOverrides) text += R"(  template <class T> static void readOrDefault(T &x, JsonVariant v, const T &flashDefault, long minValue, long maxValue){
+    if (v.success()) readInteger(x, v, minValue, maxValue);
+    else x = flashValue(flashDefault);
+  }
+)";
+  return text;
+}
+
+/**
+ * @brief The value of decimal text in units of 10^-scale, exactly: no floating point. Digits beyond the scale are rounded.
+ * Must match parseDecimal() in the generated header.
+ * @return false if the text isn't a plain decimal number (eg: it has an exponent) or doesn't fit a 32 bit long
+ */
+bool parseDecimal(const char *s, int scale, long& n){
+  bool negative = *s == '-';
+  if (*s == '-' || *s == '+') s++;
+  unsigned long v = 0;
+  int digits = 0, decimals = -1; //digits after the point; -1 before it
+  bool roundUp = false;
+  for (;; s++){
+    if (*s == '.' && decimals < 0) decimals = 0;
+    else if (*s >= '0' && *s <= '9'){
+      digits++;
+      if (decimals >= scale){
+        if (decimals++ == scale) roundUp = *s >= '5';
+        continue;
+      }
+      if (decimals >= 0) decimals++;
+      if (v > (2147483647ul - (*s - '0')) / 10) return false;
+      v = v * 10 + (*s - '0');
+    }
+    else break;
+  }
+  if (!digits || *s) return false;
+  for (decimals = max(decimals, 0); decimals < scale; decimals++){
+    if (v > 214748364ul) return false;
+    v *= 10;
+  }
+  if (roundUp && v++ == 2147483647ul) return false;
+  n = negative ? -(long)v : (long)v;
+  return true;
+}
+
+/**
+ * @brief Make the text of the exact conversions of <DECIMAL scale> fields, which are kept as longs in units of 10^-scale.
+ * Numbers are parsed from the text the json parser keeps for them, and written as raw json, so no double is involved.
+ */
+string makeDecimalHelpersText(){
+  string text = R"(
+  static bool parseDecimal(const char *s, int scale, long &n){ //exact; digits beyond the scale are rounded
+    bool negative = *s == '-';
+    if (*s == '-' || *s == '+') s++;
+    unsigned long v = 0;
+    int digits = 0, decimals = -1; //digits after the point; -1 before it
+    bool roundUp = false;
+    for (;; s++){
+      if (*s == '.' && decimals < 0) decimals = 0;
+      else if (*s >= '0' && *s <= '9'){
+        digits++;
+        if (decimals >= scale){
+          if (decimals++ == scale) roundUp = *s >= '5';
+          continue;
+        }
+        if (decimals >= 0) decimals++;
+        if (v > (2147483647ul - (*s - '0')) / 10) return false;
+        v = v * 10 + (*s - '0');
+      }
+      else break;
+    }
+    if (!digits || *s) return false;
+    for (decimals = decimals < 0 ? 0 : decimals; decimals < scale; decimals++){
+      if (v > 214748364ul) return false;
+      v *= 10;
+    }
+    if (roundUp && v++ == 2147483647ul) return false;
+    n = negative ? -(long)v : (long)v;
+    return true;
+  }
+  static char *formatDecimal(long n, int scale){ //into a buffer shared by every call, so use the text straight away
+    static char text[24];
+    char *p = text + sizeof text - 1;
+    unsigned long v = n < 0 ? 0ul - n : n;
+    *p = 0;
+    for (int i = 0; i < scale; i++, v /= 10) *--p = '0' + v % 10;
+    if (scale) *--p = '.';
+    do *--p = '0' + v % 10; while (v /= 10);
+    if (n < 0) *--p = '-';
+    return p;
+  }
+  static void readDecimal(long &x, JsonVariant v, int scale){
+    const char *s = v.as<const char *>(); //the text of a number, as parsed, or a numeric string
+    if (!s || !parseDecimal(s, scale, x)){ //missing, or eg: written with an exponent
+      static const long powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+      double d = v.as<double>() * powers[scale];
+      x = d < 0 ? d - 0.5 : d + 0.5;
+    }
+  }
+)";
+  if (makeOverrides) text += R"(  static void readOrDefault(long &x, JsonVariant v, const long &flashDefault, int scale){
+    if (v.success()) readDecimal(x, v, scale);
+    else x = flashValue(flashDefault);
+  }
+)";
+  return text;
+}
+
+bool hasNumbers(){
+  for (const FIELD& f : fields) if (f.type == "long" || f.type == "double" || isNarrowInteger(f)) return true;
+  return makeTable;
+}
+
+/**
+ * @brief Make the text of the number formatting of the values script: into a NUMBERTEXT the caller provides, so with no String, heap or
+ * sprintf for integers, and doubles as the shortest text that reads back the same rather than String(double)'s two decimals.
+ */
+string makeNumberHelpersText(){
+  return R"(
+  typedef char NUMBERTEXT[26]; //room for any long or double as text
+  static char *formatLong(NUMBERTEXT &text, long n){ //returns the first character, somewhere in text
+    char *p = text + sizeof text - 1;
+    unsigned long v = n < 0 ? 0ul - n : n;
+    *p = 0;
+    do *--p = '0' + v % 10; while (v /= 10);
+    if (n < 0) *--p = '-';
+    return p;
+  }
+  static char *formatDouble(NUMBERTEXT &text, double d){ //the shortest text that reads back as d; NaN and Infinity as javascript has them
+    if (d - d != 0) return strcpy(text, d != d ? "NaN" : d < 0 ? "-Infinity" : "Infinity");
+    static const double powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    double a = d < 0 ? -d : d;
+    for (int places = 0; a < 1e9 && places <= 6; places++){ //a few decimal places, as most settings have, need no printf
+      unsigned long long v = a * powers[places] + 0.5;
+      if (v / powers[places] != a) continue; //the fewest places that read back as d
+      char *p = text + sizeof text - 1;
+      *p = 0;
+      for (int i = 0; i < places; i++, v /= 10) *--p = '0' + v % 10;
+      if (places) *--p = '.';
+      do *--p = '0' + v % 10; while (v /= 10);
+      if (d < 0) *--p = '-';
+      return p;
+    }
+    for (int digits = 15;; digits++){ //15 digits give any shorter decimal back exactly, 17 any double
+      snprintf(text, sizeof text, "%.*g", digits, d);
+      if (digits == 17 || strtod(text, nullptr) == d) return text;
+    }
+  }
+)";
+}
+
+/**
+ * @brief The address in dotted quad text, first octet in the low byte as in the ESP8266's IPAddress. "" is 0.
+ * Must match parseIpv4() in the generated header.
+ * @return false if the text isn't four decimal octets separated by dots
+ */
+bool parseIpv4(const char *s, uint32_t& ip){
+  if (!*s) return ip = 0, true;
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++){
+    unsigned octet = 0, digits = 0;
+    while (*s >= '0' && *s <= '9' && digits++ < 3) octet = octet * 10 + (*s++ - '0');
+    if (!digits || octet > 255 || *s != (i < 3 ? '.' : '\0')) return false;
+    if (i < 3) s++;
+    v |= (uint32_t)octet << (8 * i);
+  }
+  ip = v;
+  return true;
+}
+
+/**
+ * @brief Make the text of the conversions of <IPV4> fields, which are kept as a uint32_t ready for IPAddress.
+ */
+string makeIpv4HelpersText(){
+  string text = R"(
+  static bool parseIpv4(const char *s, uint32_t &ip){ //"a.b.c.d", a in the low byte as in IPAddress; "" is 0
+    if (!*s) return ip = 0, true;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++){
+      unsigned octet = 0, digits = 0;
+      while (*s >= '0' && *s <= '9' && digits++ < 3) octet = octet * 10 + (*s++ - '0');
+      if (!digits || octet > 255 || *s != (i < 3 ? '.' : '\0')) return false;
+      if (i < 3) s++;
+      v |= (uint32_t)octet << (8 * i);
+    }
+    ip = v;
+    return true;
+  }
+  static char *formatIpv4(uint32_t ip){ //into a buffer shared by every call, so use the text straight away; 0 is ""
+    static char text[16];
+    char *p = text;
+    for (int i = 0; i < 4 && (ip || i); i++, ip >>= 8){
+      uint8_t octet = ip;
+      if (octet >= 100) *p++ = '0' + octet / 100;
+      if (octet >= 10) *p++ = '0' + octet / 10 % 10;
+      *p++ = '0' + octet % 10;
+      if (i < 3) *p++ = '.';
+    }
+    *p = 0;
+    return text;
+  }
+  static void readIpv4(uint32_t &x, JsonVariant v){
+    const char *s = v.as<const char *>();
+    if (!s || !parseIpv4(s, x)) x = 0;
+  }
+)";
+  if (makeOverrides) text += R"(  static void readIpv4OrDefault(uint32_t &x, JsonVariant v, const uint32_t &flashDefault){
+    if (v.success()) readIpv4(x, v);
+    else x = flashValue(flashDefault);
+  }
+)";
+  return text;
+}
+
+/**
+ * @brief A member of a settings struct, as declared (-l option). Sizes are those of the ESP8266, for the layout report.
+ */
+struct LAYOUTMEMBER {
+  string declaration; // the text declaring it, nested struct and all
+  int rank;           // 0 double, 1 long and String, 2 int32_t, 3 int16_t, 4 bytes and char arrays, 5 packed bool; alignment never grows with rank
+  int size;
+  int align;
+  string sizeText;    // its size as an expression for the static_assert eg: "sizeof(String)"
+};
+
+/**
+ * @brief The layout of one nested struct (-l option), as reported in the header.
+ */
+struct STRUCTLAYOUT {
+  string typeName;    // eg: "SETTINGS::DEVICE::WIFI"
+  int rank;           // of its most aligned member
+  int jsonOrderSize;  // on the ESP8266, were its members declared in json order with a byte per bool
+  int packedSize;     // on the ESP8266, as declared
+  int align;
+  string sizeText;    // the sum of its members' sizes, for the static_assert
+};
+deque<STRUCTLAYOUT> layouts; // innermost first, so each struct's layout is known before that of its parent
+string bitfieldDefaultsText = ""; //statements giving the bool bitfields their defaults, which C++11 can't do in the declaration
+
+/**
+ * @brief Layout of a leaf field of the given type (-l option).
+ */
+LAYOUTMEMBER leafLayout(const string& type, int maxLength){
+  if (maxLength) return {"", 4, maxLength + 1, 1, to_string(maxLength + 1)};
+  if (type == "double") return {"", 0, 8, 8, "sizeof(double)"};
+  if (type == "long") return {"", 1, 4, 4, "sizeof(long)"};
+  if (type == "uint32_t") return {"", 2, 4, 4, "sizeof(uint32_t)"};
+  if (type == "String") return {"", 1, 12, 4, "sizeof(String)"};
+  if (type == "bool") return makeTable ? LAYOUTMEMBER{"", 4, 1, 1, "sizeof(bool)"} : LAYOUTMEMBER{"", 5, 1, 1, ""};
+  const INTEGERTYPE *t = integerType(type);
+  if (t) return {"", t->size == 4 ? 2 : t->size == 2 ? 3 : 4, t->size, t->size, "sizeof(" + type + ")"};
+  return {"", 4, 0, 1, ""}; //unknown types are only comments
+}
+
+int roundUp(int n, int align){
+  return (n + align - 1) / align * align;
+}
+
+/**
+ * @brief Declare the members of a struct most aligned first, with the bools packed into bitfields at the end, so no padding is
+ * needed between them (-l option). Notes the layout of the struct, for the struct that holds it and for the report.
+ */
+string layoutText(vector<LAYOUTMEMBER>& members, const string& typeName){
+  STRUCTLAYOUT layout = {typeName, 4, 0, 0, 1, ""};
+  int bools = 0;
+  for (const LAYOUTMEMBER& m : members){ //as they would be in json order
+    layout.jsonOrderSize = roundUp(layout.jsonOrderSize, m.align) + m.size;
+    layout.align = max(layout.align, m.align);
+    if (m.rank == 5) bools++;
+    else layout.rank = min(layout.rank, m.rank);
+  }
+  layout.jsonOrderSize = roundUp(layout.jsonOrderSize, layout.align);
+
+  stable_sort(members.begin(), members.end(), [](const LAYOUTMEMBER& a, const LAYOUTMEMBER& b){ return a.rank < b.rank; });
+  string text;
+  map<string, int> sizeCounts; //eg: "sizeof(String)" -> 3
+  vector<string> sizeTexts;    //in order of first appearance
+  for (const LAYOUTMEMBER& m : members){
+    text += m.declaration;
+    if (m.rank == 5 || m.sizeText.empty()) continue;
+    layout.packedSize += m.size;
+    if (!sizeCounts[m.sizeText]++) sizeTexts.push_back(m.sizeText);
+  }
+  layout.packedSize = roundUp(layout.packedSize + (bools + 7) / 8, layout.align);
+  for (const string& s : sizeTexts) layout.sizeText += (layout.sizeText.empty() ? "" : " + ") + (sizeCounts[s] > 1 ? to_string(sizeCounts[s]) + " * " : "") + s;
+  if (bools) layout.sizeText += (layout.sizeText.empty() ? "" : " + ") + to_string((bools + 7) / 8);
+  if (layout.sizeText.empty()) layout.sizeText = "0";
+  layouts.push_back(layout);
+  return text;
+}
+
+/**
+ * @brief The layout report and static_asserts that the nested structs have no padding between their members (-l option).
+ * The root struct has functions and state of its own after its fields, so only the size of its fields is reported.
+ */
+string makeLayoutReportText(){
+  string text = "\n//layout of the settings (bytes on the ESP8266, in json order -> packed):\n";
+  for (const STRUCTLAYOUT& l : layouts) text += "//  " + l.typeName + (l.typeName == structureLabel ? " fields: " : ": ") + to_string(l.jsonOrderSize) + " -> " + to_string(l.packedSize) + "\n";
+  for (const STRUCTLAYOUT& l : layouts){
+    if (l.typeName == structureLabel) continue;
+    text += "static_assert(sizeof(" + l.typeName + ") == (" + l.sizeText + " + alignof(" + l.typeName + ") - 1) / alignof(" + l.typeName + ") * alignof(" + l.typeName + "), \"" + l.typeName + " is padded\");\n";
+  }
+  return text;
+}
+
+/**
+ * @brief Whether the field is a bool packed into a bitfield (-l option), which can't be bound to a reference.
+ */
+bool isBitfield(const FIELD& f){
+  return makeLayout && !makeTable && f.type == "bool" && !f.isConst; //the field table needs the offset of every member
+}
+
+/**
+ * @brief Whether any String is kept in a fixed size char array (<MAXLEN n>), ie: whether the text helpers are needed.
+ */
+bool hasTextBuffers(){
+  for (const FIELD& f : fields) if (f.maxLength) return true;
+  return false;
+}
+
+/**
+ * @brief Make the text of fingerprintOf(), which adds a value to an FNV-1a hash, for fingerprint().
+ * Strings add their characters and terminator, so "ab", "c" and "a", "bc" differ; anything else adds its bytes. Doubles are
+ * normalised first, as operator== compares them with sameValue(): -0.0 hashes as 0.0 and every NaN as the one quiet NaN.
+ */
+string makeFingerprintHelpersText(){
+  return R"(
+  static uint32_t fingerprintOf(uint32_t h, const void *p, size_t n){
+    for (const uint8_t *b = (const uint8_t *)p; n--; b++) h = (h ^ *b) * 16777619u;
+    return h;
+  }
+  template <class T> static uint32_t fingerprintOf(uint32_t h, const T &v){ return fingerprintOf(h, &v, sizeof v); }
+  template <size_t N> static uint32_t fingerprintOf(uint32_t h, const char (&s)[N]){ return fingerprintOf(h, s, strnlen(s, N - 1) + 1); }
+  static uint32_t fingerprintOf(uint32_t h, const String &s){ return fingerprintOf(h, s.c_str(), s.length() + 1); }
+  static uint32_t fingerprintOf(uint32_t h, double d){
+    if (d != d) return fingerprintOf(h, (uint64_t)0x7FF8000000000000u); //every NaN as the one quiet NaN
+    if (d == 0) d = 0; //-0.0 as 0.0
+    return fingerprintOf(h, &d, sizeof d);
+  }
+  static bool sameValue(double a, double b){ return a == b || (a != a && b != b); } //NaN is NaN, so a copy equals its original
+)";
+}
+
+/**
+ * @brief Make the text of setText(), which copies a string into a <MAXLEN n> field, truncating it to fit.
+ * It returns whether the field changed, so the setters (-d option) need no separate comparison.
+ */
+string makeTextHelpersText(){
+  return R"(
+  template <size_t N> static bool setText(char (&to)[N], const char *from){
+    if (!from) from = "";
+    size_t n = strnlen(from, N - 1);
+    if (!strncmp(to, from, n) && !to[n]) return false;
+    memcpy(to, from, n);
+    to[n] = 0;
+    return true;
+  }
+)";
+}
+
+/**
+ * @brief An object tagged <FILE name>, persisted in its own file by its own read and write functions.
+ */
+struct SUBTREE {
+  string path;       // dotted name of the object eg: "gas.diagnostics"
+  string filename;   // SPIFFS filename eg: "/gasDiag.json"
+  string writeFunctionText;
+  string readFunctionText;
+  string pruneFunctionText;
+};
+deque<SUBTREE> subtrees; // a deque so references survive nested <FILE> objects being added
+
+/**
+ * @brief An object tagged <LAZY>: read() skips it, recording where it is in the settings file, and it is parsed on first use.
+ */
+struct LAZY {
+  string path;             // dotted name of the object eg: "localServers"
+  string squaredName;      // its place in the settings file eg: root["localServers"]
+  string readFunctionText; // statements reading its fields from root[...]
+};
+deque<LAZY> lazies;
+
+/**
+ * @brief An object tagged <LAZY> that is read by read() after all (-j option, <FILE> and <VOLATILE> objects, or inside another <LAZY>
+ * object). It still gets its accessor, so code written against it builds either way.
+ */
+struct EAGERLAZY {
+  string path; // dotted name of the object eg: "localServers"
+  int lazy;    // index of the <LAZY> object it is inside, -1 if none
+};
+deque<EAGERLAZY> eagerLazies;
+
+/**
+ * @brief An object, as collected by iterateObject(), so objects of the same shape can share one struct and one set of read, write and values functions.
+ */
+struct SHAPE {
+  string path;          // dotted name of the object eg: "remoteServers.mqtt"
+  string key;           // eg: "mqtt"
+  string typeName;      // eg: "SETTINGS::REMOTESERVERS::MQTT"
+  string squaredName;   // its place in the settings file eg: root["remoteServers"]["mqtt"]
+  string declaration;   // struct MQTT {...}mqtt; as declared
+  string shape;         // the members of the declaration, unindented
+  bool isOwnRoot;       // <FILE> or <LAZY>: its statements are in functions of its own
+  int file, lazy;       // as its fields
+  string readText, writeText, valuesText; // the statements of its fields
+};
+vector<SHAPE> shapes;
+// map<string,vector<string>> dataTypes;   // holds identifier/dataype pairs - ditto
+
+/**
+ * @brief Retrieve the first (front) comment for the given key. Copy it. Delete the front comment. Return the copy.
+ * @warn Must only be called once per key per line during parsing. (Effectively treats commentsNew as a FIFO.)
+ */
+const string popFirstComment(const char* key){
+  string retval(commentsNew[key].front()); 
+  commentsNew[key].erase(commentsNew[key].begin());
+  return retval;
+}
+
+/**
+ * @brief Retrieve the first (front) datatype for the given key. Copy it. Delete the front comment. Return the copy.
+ * @warn Must only be called once per key per line during parsing. (Effectively treats dataTypes as a FIFO.)
+ */
+// const string popFirstDataType(const char* key){
+//   string retval(dataTypes[key].front()); 
+//   dataTypes[key].erase(dataTypes[key].begin());
+//   return retval;
+// }
+
+void makeValuesFunctionText(string valueName, bool isCheckBox, bool needsQuotes, const string& valueText = ""){
+  // if  isCheckbox == true
+  // add line retval += String("document.getElementById('router.useDhcp').checked = ") + (this->router.useDhcp ? "true" : "false") + ";\n";
+  // eg: if dottedName is "router.SSID",
+  // add line retval += String("values['router.SSID'] = ") + "'" + String(this->router.SSID) + "'" + ";\n";
+  
+  // clog << "makeValuesFunctionText: valueName = " << valueName << endl;
+  if (isCheckBox){
+    valuesFunctionText += R"(    retval += String("document.getElementById(')";
+    valuesFunctionText += valueName;
+    valuesFunctionText += R"(').checked = "))";
+    valuesFunctionText += " + (this->";
+    valuesFunctionText += valueName;
+    valuesFunctionText += R"( ? "true" : "false"))";
+    valuesFunctionText += R"( + ";\n";)";
+    valuesFunctionText += "\n";
+  }
+  else{
+    valuesFunctionText += R"(    retval += String("values[')";
+    valuesFunctionText += valueName;
+    valuesFunctionText += R"('] = "))";
+    if (needsQuotes) valuesFunctionText += R"( + "'")";
+    if (!valueText.empty()){ //eg: appended straight from a <MAXLEN n> char array
+      valuesFunctionText += " + ";
+      valuesFunctionText += valueText;
+    }
+    else{
+      valuesFunctionText += R"( + String(this->)";
+      valuesFunctionText += valueName;
+      valuesFunctionText += ")";
+    }
+    if (needsQuotes) valuesFunctionText += R"( + "'")";
+    valuesFunctionText += R"( + ";\n";)";
+    valuesFunctionText += "\n";
+  }
+  //retval += String("values['weather.publishDataPeriodMs'] = " ) + formatLong(number, this->weather.publishDataPeriodMs) + ";\n";
+  //clog << retval << endl;
+}
+
+/**
+ * @brief FNV-1a hash of s, starting from seed. Must match submitSlot() in the generated header.
+ */
+uint32_t fnv1a(const string& s, uint32_t seed = 2166136261u){
+  uint32_t h = seed;
+  for (unsigned char c : s){
+    h ^= c;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/**
+ * @brief Find a seed and table size for which fnv1a(name, seed) % size is unique for every name, ie: a perfect hash.
+ * Starts with a table the size of the name list and grows it until a seed is found.
+ */
+void findPerfectHash(const vector<string>& names, uint32_t& seed, uint32_t& size){
+  size = names.empty() ? 1 : names.size();
+  for (;; size += size / 4 + 1){
+    vector<bool> used(size);
+    for (uint32_t attempt = 0; attempt < 20000; attempt++){
+      seed = 2166136261u + attempt;
+      fill(used.begin(), used.end(), false);
+      bool collision = false;
+      for (const string& name : names){
+        uint32_t slot = fnv1a(name, seed) % size;
+        if (used[slot]){
+          collision = true;
+          break;
+        }
+        used[slot] = true;
+      }
+      if (!collision) return;
+    }
+  }
+}
+
+bool hasEnums(){
+  for (const FIELD& f : fields) if (!f.enumNames.empty()) return true;
+  return false;
+}
+
+/**
+ * @brief An <ENUM> name as a C++ identifier eg: "11n" -> "_11n", "auto" -> "auto_"
+ */
+string enumIdentifier(const string& name){
+  static const set<string> keywords = { //the C++17 keywords and alternative tokens
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char", "char16_t", "char32_t",
+    "class", "compl", "const", "const_cast", "constexpr", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else",
+    "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace",
+    "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+    "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local",
+    "throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while",
+    "xor", "xor_eq"};
+  string id = name;
+  for (char& c : id) if (!isalnum((unsigned char)c)) c = '_';
+  if (id.empty() || isdigit((unsigned char)id[0])) id = "_" + id;
+  if (keywords.count(id)) id += "_";
+  return id;
+}
+
+/**
+ * @brief Find an <ENUM a|b|c> tag in a comment, noting its names and removing it.
+ * @return whether there was one
+ */
+bool takeEnumTag(string& comment, vector<string>& names){
+  size_t tag = comment.find("<ENUM ");
+  if (tag == string::npos) return false;
+  size_t end = comment.find('>', tag);
+  boost::split(names, comment.substr(tag + 6, end == string::npos ? string::npos : end - tag - 6), boost::is_any_of("|"));
+  for (string& name : names) boost::trim(name);
+  comment.erase(tag, end == string::npos ? string::npos : end + 1 - tag);
+  return true;
+}
+
+/**
+ * @brief Make the text of the conversions of <ENUM> fields, which are kept as an enum class with a byte per value.
+ * Each enum has a name table and a perfect hash of its names, so a name is found with one hash and one strcmp.
+ */
+string makeEnumHelpersText(){
+  string text = R"(
+  template <class E> static void readEnum(E &x, JsonVariant v){ //an unknown name leaves x as it was
+    const char *s = v.as<const char *>();
+    long n;
+    if (s && parseEnum(s, x, n)) x = (E)n;
+  }
+)";
+  if (makeOverrides) text += R"(  template <class E> static void readEnumOrDefault(E &x, JsonVariant v, const uint8_t &flashDefault){
+    if (v.success()) readEnum(x, v);
+    else x = (E)flashValue(flashDefault);
+  }
+)";
+  for (const FIELD& f : fields){
+    if (f.enumNames.empty()) continue;
+    uint32_t seed, size;
+    findPerfectHash(f.enumNames, seed, size);
+    text += "  static const char *enumName(" + f.type + " v){\n";
+    text += "    static constexpr const char *names[] = {";
+    for (size_t i = 0; i < f.enumNames.size(); i++) text += (i ? ", \"" : "\"") + f.enumNames[i] + "\"";
+    text += "};\n";
+    text += "    return (uint8_t)v < " + to_string(f.enumNames.size()) + " ? names[(uint8_t)v] : \"\";\n";
+    text += "  }\n";
+    text += "  static bool parseEnum(const char *s, " + f.type + ", long &n){\n";
+    text += "    uint32_t h = " + to_string(seed) + "u;\n";
+    text += "    for (const char *c = s; *c; c++){\n";
+    text += "      h ^= (uint8_t)*c;\n";
+    text += "      h *= 16777619u;\n";
+    text += "    }\n";
+    text += "    switch (h % " + to_string(size) + "){\n";
+    for (size_t i = 0; i < f.enumNames.size(); i++) text += "      case " + to_string(fnv1a(f.enumNames[i], seed) % size) + ": n = " + to_string(i) + "; break;\n";
+    text += "      default: return false;\n";
+    text += "    }\n";
+    text += "    return !strcmp(s, enumName((" + f.type + ")n));\n";
+    text += "  }\n";
+  }
+  return text;
+}
+
+/**
+ * @brief Dotted name in camel case for use in generated function names eg: "device.wiFi.useMdns" -> "DeviceWiFiUseMdns"
+ */
+string camelName(const string& path){
+  string name;
+  bool startOfWord = true;
+  for (char c : path){
+    if (c == '.') startOfWord = true;
+    else{
+      name += startOfWord ? toupper(c) : c;
+      startOfWord = false;
+    }
+  }
+  return name;
+}
+
+/**
+ * @brief Name of a field's entry in the defaults table (-o option) eg: "device.wiFi.useMdns" -> "settingsDefaults.device_wiFi_useMdns"
+ */
+string defaultsName(const string& path){
+  return structureName + "Defaults." + boost::replace_all_copy(path, ".", "_");
+}
+
+/**
+ * @brief Make the text of the defaults table (-o option): the defaults from the json specification as one constant
+ * struct, in flash on the ESP. It is defined ahead of the settings struct, whose constructor copies it.
+ */
+string makeDefaultsTableText(){
+  string text = "struct " + structureLabel + "_DEFAULTS { //the defaults from the json specification\n";
+  for (const FIELD& f : fields){
+    if (f.type == "// unknown type" || f.isConst) continue;
+    string name = boost::replace_all_copy(f.path, ".", "_");
+    if (f.type == "String") text += "  char " + name + "[sizeof(" + f.value + ")];\n";
+    else if (!f.enumNames.empty()) text += "  uint8_t " + name + ";\n"; //the enum is declared in the settings struct
+    else text += "  " + f.type + " " + name + ";\n";
+  }
+  text += "};\n";
+  text += "static const " + structureLabel + "_DEFAULTS " + structureName + "Defaults PROGMEM = {\n";
+  for (const FIELD& f : fields){
+    if (f.type == "// unknown type" || f.isConst) continue;
+    text += "  " + f.value + ", //" + f.path + "\n";
+  }
+  text += "};\n\n";
+  return text;
+}
+
+/**
+ * @brief Make the text of the members that use the defaults table (-o option): the constructor, resetToDefaults() and the
+ * helpers of the sparse read and write. Only fields that differ from their defaults are written; read() gives the
+ * others their defaults.
+ */
+string makeDefaultsFunctionText(){
+  string text = "\n  " + structureLabel + "(){\n";
+  text += "    this->resetToDefaults();\n";
+  text += "  }\n";
+  text += "\n  void resetToDefaults(){ //copy the defaults table\n";
+  for (const FIELD& f : fields){
+    if (f.type == "// unknown type" || f.isConst) continue;
+    if (f.maxLength) text += "    strcpy_P(this->" + f.path + ", " + defaultsName(f.path) + ");\n";
+    else if (f.type == "String") text += "    this->" + f.path + " = FPSTR(" + defaultsName(f.path) + ");\n";
+    else if (!f.enumNames.empty()) text += "    this->" + f.path + " = (" + f.type + ")flashValue(" + defaultsName(f.path) + ");\n";
+    else text += "    this->" + f.path + " = flashValue(" + defaultsName(f.path) + ");\n";
+  }
+  text += "  }//resetToDefaults\n";
+  text += R"(
+  template <class T> static T flashValue(const T &flashDefault){
+    T v;
+    memcpy_P(&v, &flashDefault, sizeof v);
+    return v;
+  }
+  template <class T> static void readOrDefault(T &x, JsonVariant v, const T &flashDefault){
+    x = v.success() ? v.as<T>() : flashValue(flashDefault);
+  }
+  static void readOrDefault(String &x, JsonVariant v, const char *flashDefault){
+    const char *s = v.as<const char *>();
+    if (s) x = s;
+    else x = FPSTR(flashDefault);
+  }
+  template <class T> static bool isDefault(const T &x, const T &flashDefault){
+    return x == flashValue(flashDefault);
+  }
+  static bool isDefault(const String &x, const char *flashDefault){
+    return !strcmp_P(x.c_str(), flashDefault);
+  }
+)";
+  if (makeLayout) text += R"(  template <class T> static T valueOrDefault(JsonVariant v, const T &flashDefault){ //for bitfields
+    return v.success() ? v.as<T>() : flashValue(flashDefault);
+  }
+)";
+  if (hasTextBuffers()) text += R"(  template <size_t N> static void readTextOrDefault(char (&x)[N], JsonVariant v, const char *flashDefault){
+    const char *s = v.as<const char *>();
+    if (s) setText(x, s);
+    else strcpy_P(x, flashDefault); //checked to fit by json2settings
+  }
+  static bool isDefault(const char *x, const char *flashDefault){
+    return !strcmp_P(x, flashDefault);
+  }
+)";
+  return text;
+}
+
+/**
+ * @brief Name of the generated setter for a field eg: "device.wiFi.useMdns" -> "setDeviceWiFiUseMdns"
+ */
+string setterName(const FIELD& f){
+  return "set" + camelName(f.path);
+}
+
+/**
+ * @brief A statement assigning expression to field; through its setter if changes to it are being tracked.
+ */
+string assignment(const FIELD& f, const string& expression){
+  if (trackDirty && isPersisted(f)) return "this->" + setterName(f) + "(" + expression + ");";
+  if (f.maxLength) return "setText(this->" + f.path + ", " + expression + ");";
+  return "this->" + f.path + " = " + expression + ";";
+}
+
+/**
+ * @brief Make the text of visitFields(), which calls a visitor with each field - its name, dotted name, member and FIELDFLAGS - in json order,
+ * and of its const overload. Being templates, they cost nothing unless used and inline to the statements the visitor makes of them.
+ * Bitfields (-l option) can't be bound to a reference, so the visitor is given a copy, which the non const overload assigns back.
+ */
+string makeVisitorText(){
+  string text = R"(
+  enum FIELDFLAGS : uint8_t { FIELD_PRIVATE = 1, FIELD_READONLY = 2, FIELD_NOREAD = 4, FIELD_NOWRITE = 8, FIELD_VOLATILE = 16, FIELD_CONST = 32 };
+)";
+  string statements[2]; //of the non const and const overloads
+  for (const FIELD& f : fields){
+    if (f.type == "// unknown type") continue;
+    vector<string> flags;
+    if (f.isPrivate) flags.push_back("FIELD_PRIVATE");
+    if (f.isReadOnly) flags.push_back("FIELD_READONLY");
+    if (f.isVolatile) flags.push_back("FIELD_VOLATILE");
+    if (f.isConst) flags.push_back("FIELD_CONST");
+    string arguments = "\"" + f.path.substr(f.path.rfind('.') + 1) + "\", \"" + f.path + "\", ";
+    string flagsText = flags.empty() ? "0" : boost::join(flags, " | ");
+    if (isBitfield(f)){
+      statements[0] += "    { bool b = this->" + f.path + "; visit(" + arguments + "b, " + flagsText + "); this->" + f.path + " = b; }\n";
+      statements[1] += "    { const bool b = this->" + f.path + "; visit(" + arguments + "b, " + flagsText + "); }\n";
+    }
+    else for (string& s : statements) s += "    visit(" + arguments + "this->" + f.path + ", " + flagsText + ");\n";
+  }
+  text += "  template <typename Visitor> void visitFields(Visitor &&visit){ //visit(name, path, member, flags) for each field\n";
+  if (!lazies.empty()) text += "    this->loadLazy();\n";
+  text += statements[0];
+  text += "  }//visitFields\n\n";
+  text += "  template <typename Visitor> void visitFields(Visitor &&visit) const{ //<LAZY> objects as loaded so far\n";
+  text += statements[1];
+  text += "  }//visitFields\n";
+  return text;
+}
+
+/**
+ * @brief Whether the field is a row of the field table (-g option); constants and unknown types aren't.
+ */
+bool isTabled(const FIELD& f){
+  return makeTable && !f.isConst && f.type != "// unknown type";
+}
+
+/**
+ * @brief The FIELDTYPE of a row of the field table (-g option) eg: "FIELD_BOOL"
+ */
+string tableType(const FIELD& f){
+  if (f.maxLength) return "FIELD_TEXT";
+  if (isNarrowInteger(f)) return "FIELD_INTEGER";
+  if (f.scale) return "FIELD_DECIMAL";
+  if (f.isIpv4) return "FIELD_IPV4";
+  if (!f.enumNames.empty()) return "FIELD_ENUM";
+  return "FIELD_" + boost::to_upper_copy(f.type);
+}
+
+/**
+ * @brief The dotted names of the rows of the field table (-g option), each followed by the names of its enum, if any; all 0 terminated.
+ * Notes where each row's name and enum names start.
+ */
+string tablePaths(vector<size_t>& paths, vector<size_t>& enumNames){
+  string blob;
+  for (const FIELD& f : fields){
+    if (!isTabled(f)) continue;
+    paths.push_back(blob.size());
+    blob += f.path + '\0';
+    enumNames.push_back(blob.size());
+    for (const string& name : f.enumNames) blob += name + '\0';
+  }
+  return blob;
+}
+
+/**
+ * @brief Make the text of the field table (-g option): a row of {name, offset, type, flags...} per field and the names, in flash on the ESP.
+ * It is defined after the settings struct, as it needs the offsets of the members.
+ */
+string makeFieldTableText(){
+  vector<size_t> paths, enumNames;
+  string blob = tablePaths(paths, enumNames);
+  string text = "#pragma GCC diagnostic push\n";
+  text += "#pragma GCC diagnostic ignored \"-Winvalid-offsetof\" //the members used are at fixed offsets, Strings and all\n";
+  text += "const " + structureLabel + "::FIELDINFO " + structureLabel + "::fieldTable[" + to_string(paths.size()) + "] PROGMEM = {\n";
+  size_t row = 0;
+  for (const FIELD& f : fields){
+    if (!isTabled(f)) continue;
+    vector<string> flags;
+    if (f.isPrivate) flags.push_back("FIELD_PRIVATE");
+    if (f.isReadOnly) flags.push_back("FIELD_READONLY");
+    if (f.isVolatile || f.file >= 0 || f.lazy >= 0) flags.push_back("FIELD_NOREAD"); //read by their own functions, if at all
+    if (f.isVolatile || f.file >= 0) flags.push_back("FIELD_NOWRITE");
+    if (f.isVolatile) flags.push_back("FIELD_VOLATILE");
+    long size = f.maxLength ? f.maxLength + 1 : isNarrowInteger(f) ? integerType(f.type)->size : f.enumNames.size();
+    string minValue = isNarrowInteger(f) ? rangeText(f) : f.scale ? to_string(f.scale) + ", 0" : !f.enumNames.empty() ? to_string(enumNames[row]) + ", 0" : "0, 0";
+    text += "  {" + to_string(paths[row]) + ", offsetof(" + structureLabel + ", " + f.path + "), " + tableType(f) + ", " + (flags.empty() ? "0" : boost::join(flags, " | "));
+    text += ", " + to_string(size) + ", " + minValue + "}, //" + f.path + "\n";
+    row++;
+  }
+  text += "};\n";
+  text += "#pragma GCC diagnostic pop\n";
+  text += "const char " + structureLabel + "::fieldPaths[] PROGMEM =";
+  for (size_t i = 0; i < paths.size(); i++){ //a line per row, the 0 terminators as separate literals so no digit can follow a \0
+    size_t end = i + 1 < paths.size() ? paths[i + 1] : blob.size();
+    text += "\n ";
+    for (size_t start = paths[i]; start < end; start = blob.find('\0', start) + 1) text += " \"" + string(blob.c_str() + start) + "\\0\"";
+  }
+  text += ";\n";
+  return text;
+}
+
+/**
+ * @brief Make the text of the members that interpret the field table (-g option): read(), write(), getValuesScript() and submit() loop over
+ * the rows instead of having a statement per field. Only the conversions of the types in the table are included.
+ */
+string makeTableFunctionText(){
+  vector<size_t> paths, enumNames;
+  string blob = tablePaths(paths, enumNames);
+  set<string> types;
+  size_t pathSize = 1; //the longest name, or enum name, and its terminator
+  for (const FIELD& f : fields){
+    if (!isTabled(f)) continue;
+    types.insert(tableType(f));
+    pathSize = max(pathSize, f.path.size() + 1);
+    for (const string& name : f.enumNames) pathSize = max(pathSize, name.size() + 1);
+  }
+  string rows = to_string(paths.size());
+  string buffer = "[" + to_string(pathSize) + "]";
+  auto has = [&](const string& type){ return types.count(type) > 0; };
+
+  string text = R"(
+  enum FIELDTYPE : uint8_t { FIELD_BOOL, FIELD_LONG, FIELD_DOUBLE, FIELD_STRING, FIELD_TEXT, FIELD_INTEGER, FIELD_DECIMAL, FIELD_IPV4, FIELD_ENUM };
+  struct FIELDINFO { //a row of the field table
+    uint16_t path;    //of the dotted name in fieldPaths
+    uint16_t offset;  //of the member in the settings struct
+    uint8_t type;     //FIELDTYPE
+    uint8_t flags;    //FIELDFLAGS
+    uint16_t size;    //of a char array or narrow integer; the number of names of an enum
+    int32_t minValue; //the range of a narrow integer; the scale of a decimal; where the names of an enum start in fieldPaths
+    int32_t maxValue;
+  };
+)";
+  text += "  static const FIELDINFO fieldTable[" + rows + "];\n";
+  text += "  static const char fieldPaths[];\n";
+  text += R"(
+  static FIELDINFO fieldInfo(size_t row){
+    FIELDINFO e;
+    memcpy_P(&e, &fieldTable[row], sizeof e);
+    return e;
+  }
+  template <class T> static bool storeValue(uint8_t *p, T v){ //whether the value changed
+    T old;
+    memcpy(&old, p, sizeof old);
+    memcpy(p, &v, sizeof v);
+    return memcmp(&old, &v, sizeof v) != 0;
+  }
+  static JsonVariant fieldVariant(JsonObject &root, char *path){ //splits path, a copy of the dotted name, at its dots
+    JsonObject *o = &root;
+    char *key = path;
+    for (char *dot; (dot = strchr(key, '.')); key = dot + 1){
+      *dot = 0;
+      o = &(*o)[key].as<JsonObject &>();
+    }
+    return o->get<JsonVariant>(key);
+  }
+  static JsonObject &fieldParent(JsonObject &root, char *path, char *&key){ //likewise, making the objects on the way
+    JsonObject *o = &root;
+    key = path;
+    for (char *dot; (dot = strchr(key, '.')); key = dot + 1){
+      *dot = 0;
+      JsonObject &child = (*o)[key].as<JsonObject &>();
+      o = child.success() ? &child : &o->createNestedObject(key); //keys from path are copied into the json buffer
+    }
+    return *o;
+  }
+)";
+  if (has("FIELD_TEXT")) text += R"(  static bool storeText(char *to, size_t size, const char *from){ //truncated to fit, as setText()
+    if (!from) from = "";
+    size_t n = strnlen(from, size - 1);
+    if (!strncmp(to, from, n) && !to[n]) return false;
+    memcpy(to, from, n);
+    to[n] = 0;
+    return true;
+  }
+)";
+  if (has("FIELD_INTEGER")) text += R"(  static long loadInteger(const uint8_t *p, const FIELDINFO &e){
+    switch (e.size){
+      case 1: return e.minValue < 0 ? (long)*(const int8_t *)p : (long)*p;
+      case 2: return e.minValue < 0 ? (long)*(const int16_t *)p : (long)*(const uint16_t *)p;
+      default: return *(const int32_t *)p;
+    }
+  }
+  static bool storeInteger(uint8_t *p, const FIELDINFO &e, long n){
+    switch (e.size){
+      case 1: return storeValue(p, (uint8_t)n);
+      case 2: return storeValue(p, (uint16_t)n);
+      default: return storeValue(p, (int32_t)n);
+    }
+  }
+)";
+  if (has("FIELD_ENUM")) text += R"(  static bool fieldEnum(const FIELDINFO &e, const char *s, long &n){ //the index of s among the names of an enum
+    const char *name = fieldPaths + e.minValue;
+    for (n = 0; n < e.size; n++, name += strlen_P(name) + 1) if (!strcmp_P(s, name)) return true;
+    return false;
+  }
+  static char *fieldEnumName(const FIELDINFO &e, uint8_t n, char *name){
+    const char *p = fieldPaths + e.minValue;
+    for (uint8_t i = 0; i < n && i < e.size; i++) p += strlen_P(p) + 1;
+    if (n < e.size) strcpy_P(name, p);
+    else *name = 0;
+    return name;
+  }
+)";
+
+  text += "\n  void readTable(JsonObject &root){ //the fields read() reads\n";
+  text += "    char path" + buffer + ";\n";
+  text += "    for (size_t row = 0; row < " + rows + "; row++){\n";
+  text += R"(      FIELDINFO e = fieldInfo(row);
+      if (e.flags & FIELD_NOREAD) continue;
+      strcpy_P(path, fieldPaths + e.path);
+      JsonVariant v = fieldVariant(root, path);
+      uint8_t *p = (uint8_t *)this + e.offset;
+)";
+  if (has("FIELD_INTEGER") || has("FIELD_ENUM")) text += "      long n;\n";
+  text += "      switch (e.type){\n";
+  if (has("FIELD_BOOL")) text += "        case FIELD_BOOL: *(bool *)p = v.as<bool>(); break;\n";
+  if (has("FIELD_LONG")) text += "        case FIELD_LONG: *(long *)p = v.as<long>(); break;\n";
+  if (has("FIELD_DOUBLE")) text += "        case FIELD_DOUBLE: *(double *)p = v.as<double>(); break;\n";
+  if (has("FIELD_STRING")) text += "        case FIELD_STRING: *(String *)p = v.as<char*>(); break;\n";
+  if (has("FIELD_TEXT")) text += "        case FIELD_TEXT: storeText((char *)p, e.size, v.as<const char*>()); break;\n";
+  if (has("FIELD_INTEGER")) text += "        case FIELD_INTEGER: readInteger(n, v, e.minValue, e.maxValue); storeInteger(p, e, n); break;\n";
+  if (has("FIELD_DECIMAL")) text += "        case FIELD_DECIMAL: readDecimal(*(long *)p, v, e.minValue); break;\n";
+  if (has("FIELD_IPV4")) text += "        case FIELD_IPV4: readIpv4(*(uint32_t *)p, v); break;\n";
+  if (has("FIELD_ENUM")) text += "        case FIELD_ENUM: if (v.as<const char*>() && fieldEnum(e, v.as<const char*>(), n)) *p = n; break;\n";
+  text += "      }\n";
+  text += "    }\n";
+  text += "  }//readTable\n";
+
+  text += "\n  void writeTable(JsonObject &root){ //the fields write() writes, in struct order\n";
+  text += "    char path" + buffer + ";\n";
+  if (has("FIELD_ENUM")) text += "    char name" + buffer + ";\n";
+  text += "    for (size_t row = 0; row < " + rows + "; row++){\n";
+  text += R"(      FIELDINFO e = fieldInfo(row);
+      if (e.flags & FIELD_NOWRITE) continue;
+      strcpy_P(path, fieldPaths + e.path);
+      char *key;
+      JsonObject &o = fieldParent(root, path, key);
+      const uint8_t *p = (const uint8_t *)this + e.offset;
+      switch (e.type){
+)";
+  if (has("FIELD_BOOL")) text += "        case FIELD_BOOL: o.set(key, *(const bool *)p); break;\n";
+  if (has("FIELD_LONG")) text += "        case FIELD_LONG: o.set(key, *(const long *)p); break;\n";
+  if (has("FIELD_DOUBLE")) text += "        case FIELD_DOUBLE: o.set(key, *(const double *)p); break;\n";
+  if (has("FIELD_STRING")) text += "        case FIELD_STRING: o.set(key, *(const String *)p); break;\n";
+  if (has("FIELD_TEXT")) text += "        case FIELD_TEXT: o.set(key, (char *)p); break; //copied into the json buffer\n";
+  if (has("FIELD_INTEGER")) text += "        case FIELD_INTEGER: o.set(key, loadInteger(p, e)); break;\n";
+  if (has("FIELD_DECIMAL")) text += "        case FIELD_DECIMAL: o.set(key, RawJson(formatDecimal(*(const long *)p, e.minValue))); break;\n";
+  if (has("FIELD_IPV4")) text += "        case FIELD_IPV4: o.set(key, formatIpv4(*(const uint32_t *)p)); break;\n";
+  if (has("FIELD_ENUM")) text += "        case FIELD_ENUM: o.set(key, fieldEnumName(e, *p, name)); break;\n";
+  text += "      }\n";
+  text += "    }\n";
+  text += "  }//writeTable\n";
+
+  text += "\n  void valuesTable(String &retval){ //the values script lines of the fields on the form\n";
+  text += "    char path" + buffer + ";\n";
+  text += "    NUMBERTEXT number;\n";
+  text += "    for (size_t row = 0; row < " + rows + "; row++){\n";
+  text += R"(      FIELDINFO e = fieldInfo(row);
+      if (e.flags & FIELD_PRIVATE) continue;
+      strcpy_P(path, fieldPaths + e.path);
+      const uint8_t *p = (const uint8_t *)this + e.offset;
+)";
+  if (has("FIELD_BOOL")) text += R"(      if (e.type == FIELD_BOOL){
+        retval += String("document.getElementById('") + path + "').checked = " + (*(const bool *)p ? "true" : "false") + ";\n";
+        continue;
+      }
+)";
+  text += "      const char *quote = e.type == FIELD_STRING || e.type == FIELD_TEXT || e.type == FIELD_IPV4 || e.type == FIELD_ENUM ? \"'\" : \"\";\n";
+  text += "      retval += String(\"values['\") + path + \"'] = \" + quote;\n";
+  text += "      switch (e.type){\n";
+  if (has("FIELD_LONG")) text += "        case FIELD_LONG: retval += formatLong(number, *(const long *)p); break;\n";
+  if (has("FIELD_DOUBLE")) text += "        case FIELD_DOUBLE: retval += formatDouble(number, *(const double *)p); break;\n";
+  if (has("FIELD_STRING")) text += "        case FIELD_STRING: retval += *(const String *)p; break;\n";
+  if (has("FIELD_TEXT")) text += "        case FIELD_TEXT: retval += (const char *)p; break;\n";
+  if (has("FIELD_INTEGER")) text += "        case FIELD_INTEGER: retval += formatLong(number, loadInteger(p, e)); break;\n";
+  if (has("FIELD_DECIMAL")) text += "        case FIELD_DECIMAL: retval += formatDecimal(*(const long *)p, e.minValue); break;\n";
+  if (has("FIELD_IPV4")) text += "        case FIELD_IPV4: retval += formatIpv4(*(const uint32_t *)p); break;\n";
+  if (has("FIELD_ENUM")) text += "        case FIELD_ENUM: retval += fieldEnumName(e, *p, path); break;\n";
+  text += "      }\n";
+  text += "      retval += String(quote) + \";\\n\";\n";
+  text += "    }\n";
+  text += "  }//valuesTable\n";
+  return text;
+}
+
+/**
+ * @brief The size of the field table (-g option) - its rows and the names they point into - also told on clog, and a static_assert
+ * that the rows are unpadded. What the table saves in code depends on the compiler and the target, so it isn't guessed at here:
+ * "make flash-report" compiles read(), write(), getValuesScript() and submit() both ways and compares the sizes.
+ */
+string makeTableReportText(){
+  const size_t rowBytes = sizeof(uint16_t) * 2 + 2 + sizeof(uint16_t) + sizeof(int32_t) * 2;
+  vector<size_t> paths, enumNames;
+  size_t blobBytes = tablePaths(paths, enumNames).size();
+  size_t tableBytes = paths.size() * rowBytes + blobBytes;
+  clog << "Field table: " << paths.size() << " rows, " << tableBytes << " bytes with the names; make flash-report measures what -g saves." << endl;
+  string text = "\n//field table: " + to_string(paths.size()) + " rows * " + to_string(rowBytes) + " + " + to_string(blobBytes) + " of names: " + to_string(tableBytes) + " bytes of flash\n";
+  text += "static_assert(sizeof(" + structureLabel + "::FIELDINFO) == " + to_string(rowBytes) + ", \"FIELDINFO is padded\");\n";
+  return text;
+}
+
+/**
+ * @brief Make the text of submit() for the field table (-g option): each request argument is looked up in the table, a strcmp_P per row,
+ * and converted by its row's type. Checkboxes are only sent when checked, so the ones seen are noted and all the others are cleared afterwards.
+ * With -d the fields that change are marked dirty, as their setters would.
+ */
+string makeTableSubmitFunctionText(){
+  set<string> types;
+  size_t rows = 0;
+  for (const FIELD& f : fields){
+    if (!isTabled(f)) continue;
+    rows++;
+    if (!f.isPrivate && !f.isReadOnly) types.insert(tableType(f));
+  }
+  auto has = [&](const string& type){ return types.count(type) > 0; };
+  string changed = trackDirty ? "changed = " : "";
+
+  string text = "\n  template <class WEBSERVER> void submit(WEBSERVER &server){\n";
+  if (!lazies.empty()) text += "    this->loadLazy(); //so the fields submitted aren't overwritten later\n";
+  if (has("FIELD_BOOL")) text += "    uint8_t checked[" + to_string((rows + 7) / 8) + "] = {0}; //a bit per row\n";
+  text += "    for (int i = 0; i < server.args(); i++){\n";
+  text += "      const String &name = server.argName(i);\n";
+  text += "      const String &value = server.arg(i);\n";
+  if (trackDirty) text += "      int bit = -1; //the dirty bit of the row, as numbered by the setters\n";
+  text += "      for (size_t row = 0; row < " + to_string(rows) + "; row++){\n";
+  text += "        FIELDINFO e = fieldInfo(row);\n";
+  if (trackDirty) text += "        if (!(e.flags & FIELD_VOLATILE)) bit++;\n";
+  text += "        if ((e.flags & (FIELD_PRIVATE | FIELD_READONLY)) || strcmp_P(name.c_str(), fieldPaths + e.path)) continue;\n";
+  text += "        uint8_t *p = (uint8_t *)this + e.offset;\n";
+  if (has("FIELD_INTEGER") || has("FIELD_DECIMAL") || has("FIELD_ENUM")) text += "        long n;\n";
+  if (has("FIELD_IPV4")) text += "        uint32_t ip;\n";
+  if (trackDirty) text += "        bool changed = false;\n";
+  text += "        switch (e.type){\n";
+  if (has("FIELD_BOOL")) text += "          case FIELD_BOOL: checked[row / 8] |= 1 << row % 8; break;\n";
+  if (has("FIELD_LONG")) text += "          case FIELD_LONG: " + changed + "storeValue(p, strtol(value.c_str(), nullptr, 10)); break;\n";
+  if (has("FIELD_DOUBLE")) text += "          case FIELD_DOUBLE: " + changed + "storeValue(p, strtod(value.c_str(), nullptr)); break;\n";
+  if (has("FIELD_STRING")) text += "          case FIELD_STRING: " + string(trackDirty ? "changed = *(String *)p != value; " : "") + "*(String *)p = value; break;\n";
+  if (has("FIELD_TEXT")) text += "          case FIELD_TEXT: " + changed + "storeText((char *)p, e.size, value.c_str()); break;\n";
+  if (has("FIELD_INTEGER")) text += "          case FIELD_INTEGER: if (parseInteger(value.c_str(), e.minValue, e.maxValue, n)) " + changed + "storeInteger(p, e, n); break; //out of range values are ignored\n";
+  if (has("FIELD_DECIMAL")) text += "          case FIELD_DECIMAL: if (parseDecimal(value.c_str(), e.minValue, n)) " + changed + "storeValue(p, n); break; //as are malformed ones\n";
+  if (has("FIELD_IPV4")) text += "          case FIELD_IPV4: if (parseIpv4(value.c_str(), ip)) " + changed + "storeValue(p, ip); break;\n";
+  if (has("FIELD_ENUM")) text += "          case FIELD_ENUM: if (fieldEnum(e, value.c_str(), n)) " + changed + "storeValue(p, (uint8_t)n); break;\n";
+  text += "        }\n";
+  if (trackDirty) text += "        if (changed && !(e.flags & FIELD_VOLATILE)) this->dirty[bit / 32] |= 1u << bit % 32;\n";
+  text += "        break;\n";
+  text += "      }\n";
+  text += "    }\n";
+  if (has("FIELD_BOOL")){
+    if (trackDirty) text += "    int bit = -1;\n";
+    text += "    for (size_t row = 0; row < " + to_string(rows) + "; row++){\n";
+    text += "      FIELDINFO e = fieldInfo(row);\n";
+    if (trackDirty) text += "      if (!(e.flags & FIELD_VOLATILE)) bit++;\n";
+    text += "      if (e.type != FIELD_BOOL || (e.flags & (FIELD_PRIVATE | FIELD_READONLY))) continue;\n";
+    text += "      " + string(trackDirty ? "if (" : "") + "storeValue((uint8_t *)this + e.offset, (bool)(checked[row / 8] >> row % 8 & 1))";
+    text += trackDirty ? " && !(e.flags & FIELD_VOLATILE)) this->dirty[bit / 32] |= 1u << bit % 32;\n" : ";\n";
+    text += "    }\n";
+  }
+  text += "  }//submit\n";
+  return text;
+}
+
+/**
+ * @brief Make the text of submit(), which applies a submitted html form to the settings.
+ * The request arguments are scanned once; each argument name is mapped to its field with a perfect hash
+ * so there is one hash and one strcmp per argument instead of a hasArg()/arg() scan per field.
+ * Checkboxes are only sent when checked, so the ones seen are noted and all the others are cleared afterwards.
+ */
+string makeSubmitFunctionText(){
+  vector<const FIELD*> submitted;
+  vector<string> names;
+  for (const FIELD& f : fields){
+    if (f.isPrivate || f.isReadOnly || f.type == "// unknown type") continue;
+    submitted.push_back(&f);
+    names.push_back(f.path);
+  }
+  uint32_t seed, size;
+  findPerfectHash(names, seed, size);
+
+  int checkBoxes = 0;
+  map<uint32_t, int> checkBoxBits; // slot/bit pairs
+  for (const FIELD* f : submitted) if (f->type == "bool") checkBoxBits[fnv1a(f->path, seed) % size] = checkBoxes++;
+  sort(submitted.begin(), submitted.end(), [&](const FIELD* a, const FIELD* b){ return fnv1a(a->path, seed) % size < fnv1a(b->path, seed) % size; });
+
+  string text;
+  text += "\n  static uint32_t submitSlot(const char *name){ //perfect hash of the submittable field names\n";
+  text += "    uint32_t h = " + to_string(seed) + "u;\n";
+  text += "    while (*name){\n";
+  text += "      h ^= (uint8_t)*name++;\n";
+  text += "      h *= 16777619u;\n";
+  text += "    }\n";
+  text += "    return h % " + to_string(size) + ";\n";
+  text += "  }//submitSlot\n\n";
+
+  text += "  template <class WEBSERVER> void submit(WEBSERVER &server){\n";
+  if (!lazies.empty()) text += "    this->loadLazy(); //so the fields submitted aren't overwritten later\n";
+  if (checkBoxes) text += "    uint8_t checked[" + to_string((checkBoxes + 7) / 8) + "] = {0};\n";
+  for (const FIELD* f : submitted) if (isNarrowInteger(*f) || f->scale || !f->enumNames.empty()){
+    text += "    long n;\n";
+    break;
+  }
+  for (const FIELD* f : submitted) if (f->isIpv4){
+    text += "    uint32_t ip;\n";
+    break;
+  }
+  text += "    for (int i = 0; i < server.args(); i++){\n";
+  text += "      const String &name = server.argName(i);\n";
+  text += "      const String &value = server.arg(i);\n";
+  text += "      switch (submitSlot(name.c_str())){\n";
+  for (const FIELD* f : submitted){
+    uint32_t slot = fnv1a(f->path, seed) % size;
+    text += "        case " + to_string(slot) + ":\n";
+    text += R"(          if (!strcmp(name.c_str(), ")" + f->path + R"("))";
+    if (isNarrowInteger(*f)) text += " && parseInteger(value.c_str(), " + rangeText(*f) + ", n)"; //out of range values are ignored
+    if (f->scale) text += " && parseDecimal(value.c_str(), " + to_string(f->scale) + ", n)"; //as are malformed ones
+    if (f->isIpv4) text += " && parseIpv4(value.c_str(), ip)";
+    if (!f->enumNames.empty()) text += " && parseEnum(value.c_str(), this->" + f->path + ", n)"; //unknown names are ignored
+    text += ") ";
+    if (f->type == "bool"){
+      text += "checked[" + to_string(checkBoxBits[slot] / 8) + "] |= " + to_string(1 << (checkBoxBits[slot] % 8)) + ";\n";
+    }
+    else if (isNarrowInteger(*f)) text += assignment(*f, "(" + f->type + ")n") + "\n";
+    else if (f->scale) text += assignment(*f, "n") + "\n";
+    else if (f->isIpv4) text += assignment(*f, "ip") + "\n";
+    else if (!f->enumNames.empty()) text += assignment(*f, "(" + f->type + ")n") + "\n";
+    else if (f->type == "long") text += assignment(*f, "strtol(value.c_str(), nullptr, 10)") + "\n";
+    else if (f->type == "double") text += assignment(*f, "strtod(value.c_str(), nullptr)") + "\n";
+    else text += assignment(*f, f->maxLength ? "value.c_str()" : "value") + "\n";
+    text += "          break;\n";
+  }
+  text += "      }\n";
+  text += "    }\n";
+  for (const FIELD* f : submitted){
+    if (f->type != "bool") continue;
+    uint32_t slot = fnv1a(f->path, seed) % size;
+    text += "    " + assignment(*f, "checked[" + to_string(checkBoxBits[slot] / 8) + "] & " + to_string(1 << (checkBoxBits[slot] % 8))) + "\n";
+  }
+  text += "  }//submit\n";
+  return text;
+}
+
+/**
+ * @brief Make the text of the dirty tracking members (-d option): a bit per persisted field, set by the field's
+ * setter when the value actually changes and cleared by read() and write().
+ */
+string makeDirtyFunctionText(){
+  int persisted = 0;
+  for (const FIELD& f : fields) if (isPersisted(f)) persisted++;
+  int words = (persisted + 31) / 32;
+
+  string text;
+  text += "\n  uint32_t dirty[" + to_string(words) + "] = {0}; //a bit per persisted field, in struct order\n";
+  text += R"(
+  bool isDirty() const {
+    for (uint32_t bits : this->dirty) if (bits) return true;
+    return false;
+  }
+  void clearDirty(){
+    memset(this->dirty, 0, sizeof this->dirty);
+  }
+  bool writeIfDirty(){ //skip the write altogether if nothing has changed
+    return !this->isDirty() || this->write();
+  }
+)";
+  if (makeJournal) boost::replace_first(text, "this->write();\n  }", "this->writeDirty(); //appended to the journal\n  }");
+  int bit = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    string parameter = f.maxLength ? "const char *v" : f.type == "String" ? "const String &v" : f.type + " v";
+    text += "  void " + setterName(f) + "(" + parameter + "){\n";
+    if (f.lazy >= 0) text += "    this->loadLazy(" + to_string(f.lazy) + ");\n";
+    if (f.maxLength) text += "    if (!setText(this->" + f.path + ", v)) return;\n";
+    else{
+      text += "    if (this->" + f.path + " == v) return;\n";
+      text += "    this->" + f.path + " = v;\n";
+    }
+    text += "    this->dirty[" + to_string(bit / 32) + "] |= 1u << " + to_string(bit % 32) + ";\n";
+    text += "  }\n";
+    bit++;
+  }
+  return text;
+}
+
+/**
+ * @brief Statements clearing the dirty bits of the fields kept in the given file (-1 for the main settings file), so that
+ * reading or writing one file leaves the changes to the others pending.
+ */
+string clearDirtyText(int file, const string& indent = "    "){
+  if (subtrees.empty()) return indent + "this->clearDirty();\n";
+  vector<uint32_t> masks;
+  int bit = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    if (bit % 32 == 0) masks.push_back(0);
+    if (f.file == file) masks.back() |= 1u << bit % 32;
+    bit++;
+  }
+  string text;
+  for (size_t i = 0; i < masks.size(); i++){
+    if (!masks[i]) continue;
+    if (masks[i] == 0xFFFFFFFFu){
+      text += indent + "this->dirty[" + to_string(i) + "] = 0;\n";
+      continue;
+    }
+    char mask[12];
+    snprintf(mask, sizeof mask, "0x%08Xu", ~masks[i]);
+    text += indent + "this->dirty[" + to_string(i) + "] &= " + mask + ";\n";
+  }
+  return text;
+}
+
+/**
+ * @brief The test of whether any field of the given file (-1 for the main settings file) is dirty, eg: this->dirty[0] & 0x00000300u
+ */
+string isDirtyText(int file){
+  vector<uint32_t> masks;
+  int bit = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    if (bit % 32 == 0) masks.push_back(0);
+    if (f.file == file) masks.back() |= 1u << bit % 32;
+    bit++;
+  }
+  string text;
+  for (size_t i = 0; i < masks.size(); i++){
+    if (!masks[i]) continue;
+    char mask[12];
+    snprintf(mask, sizeof mask, "0x%08Xu", masks[i]);
+    text += string(text.empty() ? "" : " || ") + "this->dirty[" + to_string(i) + "] & " + mask;
+  }
+  return text.empty() ? "false" : text;
+}
+
+/**
+ * @brief Make the text of the read and write functions of each <FILE> subtree eg: readGasDiagnostics(), writeGasDiagnostics().
+ * The subtree object is the root of its file. While there is no such file it is read from the settings file, eg:
+ * readGasDiagnosticsFromSettingsFile(), and failing that keeps its defaults; neither is a read failure.
+ */
+string makeSubtreeFunctionText(){
+  string text;
+  for (size_t i = 0; i < subtrees.size(); i++){
+    const SUBTREE& t = subtrees[i];
+    string name = camelName(t.path);
+    string writeText = "\n  bool write" + name + "() {\n";
+    writeText += "    DynamicJsonBuffer jb(JSON_BUF_SIZE);\n";
+    writeText += "    JsonObject &root = jb.createObject();\n";
+    writeText += t.writeFunctionText;
+    writeText += t.pruneFunctionText;
+    writeText += "\n    OUT(\"" + t.filename + "\");\n";
+    if (trackDirty) writeText += clearDirtyText(i);
+    writeText += "    return true;\n";
+    writeText += "  }//write" + name + "\n";
+
+    string parseText = readInMemory ? "jb.parseObject(settingsFile.json);\n" : "settingsFile.parseObject(jb);\n";
+    string readText = "\n  int read" + name + "() {\n";
+    readText += "    DynamicJsonBuffer jb(JSON_BUF_SIZE);\n";
+    readText += "    IN(\"" + t.filename + "\");\n";
+    readText += "    if (!settingsFile) return this->read" + name + "FromSettingsFile();\n";
+    readText += "    JsonObject &root = " + parseText;
+    readText += "    if (!root.success()) return READ_PARSE_FAIL;\n";
+    readText += t.readFunctionText;
+    readText += "\n    settingsFile.close();\n";
+    if (trackDirty) readText += clearDirtyText(i);
+    readText += "    return READ_OK;\n";
+    readText += "  }//read" + name + "\n";
+
+    //before the object had a file of its own it was in the settings file, eg: on a device upgraded from a single file
+    vector<string> keys;
+    boost::split(keys, t.path, boost::is_any_of("."));
+    string objectText = "settingsRoot";
+    for (const string& key : keys) objectText += "[\"" + key + "\"]";
+    string fallbackText = "\n  int read" + name + "FromSettingsFile() { //no " + t.filename + " yet: take the object from the settings file, or keep the defaults\n";
+    fallbackText += "    DynamicJsonBuffer jb(JSON_BUF_SIZE);\n";
+    fallbackText += "    IN(this->filename);\n";
+    fallbackText += "    if (!settingsFile) return READ_OK;\n";
+    fallbackText += "    JsonObject &settingsRoot = " + parseText;
+    fallbackText += "    JsonObject &root = " + objectText + ".as<JsonObject>();\n";
+    fallbackText += "    if (!root.success()) return READ_OK;\n";
+    fallbackText += t.readFunctionText;
+    fallbackText += "\n    settingsFile.close();\n";
+    if (trackDirty) fallbackText += clearDirtyText(i);
+    fallbackText += "    return READ_OK;\n";
+    fallbackText += "  }//read" + name + "FromSettingsFile\n";
+    text += writeText + readText + fallbackText;
+  }
+  return text;
+}
+
+/**
+ * @brief Make the text of read() and write() when there are <FILE> subtrees: they cover every file, the main settings file
+ * through readSettingsFile() and writeSettingsFile(). write() saves the subtrees first; read() only reads them once the
+ * main file has been read and returns the first failure.
+ */
+string makeComposedFunctionText(){
+  string text = "\n  bool write() {\n";
+  text += "    bool ok = true;\n";
+  for (const SUBTREE& t : subtrees) text += "    ok = this->write" + camelName(t.path) + "() && ok;\n";
+  text += "    return this->writeSettingsFile() && ok;\n";
+  text += "  }//write\n";
+
+  if (makeJournal){ //the subtrees aren't journalled: those with dirty fields are written whole
+    text += "\n  bool writeDirty() {\n";
+    text += "    bool ok = true;\n";
+    for (size_t i = 0; i < subtrees.size(); i++) text += "    if (" + isDirtyText(i) + ") ok = this->write" + camelName(subtrees[i].path) + "() && ok;\n";
+    text += "    return this->writeDirtySettingsFile() && ok;\n";
+    text += "  }//writeDirty\n";
+  }
+
+  text += "\n  int read() {\n";
+  text += "    int r = this->readSettingsFile();\n";
+  text += "    if (r != READ_OK) return r;\n";
+  for (const SUBTREE& t : subtrees){
+    if (&t == &subtrees[0]) text += "    r = this->read" + camelName(t.path) + "();\n";
+    else text += string(&t == &subtrees[1] ? "    int s = " : "    s = ") + "this->read" + camelName(t.path) + "();\n    if (r == READ_OK) r = s;\n";
+  }
+  text += "    return r;\n";
+  text += "  }//read\n";
+  return text;
+}
+
+/**
+ * @brief Make the text of the deferred write scheduler (-w option). requestWrite() only notes that the settings need saving;
+ * service(), called from the main loop, writes once WRITE_COALESCE_MS have passed since the first outstanding request and
+ * WRITE_MIN_INTERVAL_MS since the last write. Time is passed in so the host can drive it with a fake clock.
+ * Every write() counts, not just the scheduler's: write() notes that it wrote, and the next call that is given the time
+ * - service(), flushWrite(nowMs) - takes that as the time of the write.
+ */
+string makeSchedulerFunctionText(){
+  return R"(
+  uint32_t writeRequests = 0;     //requestWrite() calls
+  uint32_t scheduledWrites = 0;   //writes made by service() and flushWrite()
+  bool writePending = false;
+  bool writeRequestTimed = false; //service() has seen the pending request
+  bool everWritten = false;
+  bool writeUntimed = false;      //write() has written since the scheduler was last given the time
+  uint32_t writeRequestMs = 0;    //when the pending request was made, or service() first saw it
+  uint32_t lastWriteMs = 0;
+
+  void requestWrite(){ //the coalescing starts at the next service()
+    this->writeRequests++;
+    this->writePending = true;
+  }
+
+  void requestWrite(uint32_t nowMs){ //the coalescing starts now
+    this->requestWrite();
+    if (this->writeRequestTimed) return;
+    this->writeRequestTimed = true;
+    this->writeRequestMs = nowMs;
+  }
+
+  void timeWrite(uint32_t nowMs){ //a write() since the last call counts as made now
+    if (!this->writeUntimed) return;
+    this->writeUntimed = false;
+    this->everWritten = true;
+    this->lastWriteMs = nowMs;
+  }
+
+  bool service(uint32_t nowMs){ //returns true if it wrote
+    this->timeWrite(nowMs);
+    if (!this->writePending) return false;
+    if (!this->writeRequestTimed){
+      this->writeRequestTimed = true;
+      this->writeRequestMs = nowMs;
+    }
+    if (nowMs - this->writeRequestMs < WRITE_COALESCE_MS) return false;
+    if (this->everWritten && nowMs - this->lastWriteMs < WRITE_MIN_INTERVAL_MS) return false;
+    this->everWritten = true;
+    this->lastWriteMs = nowMs; //a failed write is retried after the minimum interval too
+    bool ok = this->flushWrite();
+    this->writeUntimed = false;
+    return ok;
+  }//service
+#ifdef Arduino_h
+  bool service(){
+    return this->service(millis());
+  }
+#endif
+
+  bool flushWrite(){ //write now if a write has been requested, eg: before a restart
+    if (!this->writePending) return true;
+    if (!this->write()) return false;
+    this->writePending = false;
+    this->writeRequestTimed = false;
+    this->scheduledWrites++;
+    return true;
+  }//flushWrite
+
+  bool flushWrite(uint32_t nowMs){ //and start the minimum interval now
+    bool ok = this->flushWrite();
+    this->timeWrite(nowMs);
+    return ok;
+  }
+)";
+}
+
+/**
+ * @brief The schema hash expression for binary files: covers the field names and types and the version so a file
+ * written by a different settings.h is ignored. Type sizes are mixed in by the compiler.
+ */
+string schemaHashText(){
+  string schema;
+  for (const FIELD& f : fields){
+    if (f.path == "version" && f.isConst) schema += f.value; //still distinguishes the versions
+    if (!isPersisted(f)) continue;
+    schema += f.path + ":" + f.type + ";";
+    if (f.path == "version") schema += f.value;
+  }
+  char hash[12];
+  snprintf(hash, sizeof hash, "0x%08Xu", fnv1a(schema));
+  return string("(") + hash + " ^ sizeof(long) << 8 ^ sizeof(double) << 16)";
+}
+
+/**
+ * @brief Make the text of the helpers shared by the binary file formats (-a, -b and -j options):
+ * crc32, file load (0 terminated, optionally just a range)/save/append and the encoders of single values. A saved file is written
+ * to a temporary file that replaces it, so a power cut leaves either version; on SPIFFS, which can't rename over a file, recoverFile()
+ * finishes a replacement that was cut short.
+ * Scalars are stored as they are in memory, strings as a 16 bit length, the characters and a terminating 0.
+ */
+string makeBinaryHelpersText(){
+  string text = R"(
+  static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0){ //crc is that of the bytes before p, if any
+    static const uint32_t nibbles[16] = {
+      0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+      0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu};
+    crc = ~crc;
+    while (n--){
+      crc = nibbles[(crc ^ *p) & 0x0F] ^ (crc >> 4);
+      crc = nibbles[(crc ^ (*p++ >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+  }//crc32
+
+#ifdef Arduino_h
+  static uint8_t *loadBytes(const char *f, size_t &n, size_t limit = (size_t)-1, size_t offset = 0){
+    recoverFile(f);
+    File file = SPIFFS.open(f, "r");
+    if (!file || file.size() < offset || !file.seek(offset, SeekSet)) return nullptr;
+    n = min((size_t)file.size() - offset, limit);
+    uint8_t *buf = (uint8_t *)malloc(n + 1);
+    if (buf && file.read(buf, n) != n){
+      free(buf);
+      buf = nullptr;
+    }
+    if (buf) buf[n] = 0;
+    file.close();
+    return buf;
+  }//loadBytes
+
+  static bool saveBytes(const char *f, const uint8_t *buf, size_t n, const char *mode = "w"){
+    //a whole file is written to a temporary file first; SPIFFS won't rename over f, so it is removed just before the rename
+    String temp = *mode == 'a' ? String(f) : String(f) + ".tmp";
+    File file = SPIFFS.open(temp, mode);
+    if (!file) return false;
+    bool ok = file.write(buf, n) == n;
+    file.close();
+    if (*mode == 'a') return ok;
+    if (!ok){
+      SPIFFS.remove(temp);
+      return false;
+    }
+    return removeFile(f) && SPIFFS.rename(temp, f);
+  }//saveBytes
+
+  static void recoverFile(const char *f){ //a power cut between saveBytes() removing f and renaming its replacement leaves just the replacement
+    String temp = String(f) + ".tmp";
+    if (!SPIFFS.exists(f) && SPIFFS.exists(temp)) SPIFFS.rename(temp, f);
+  }
+
+  static bool removeFile(const char *f){
+    return !SPIFFS.exists(f) || SPIFFS.remove(f);
+  }
+#else
+  static uint8_t *loadBytes(const char *f, size_t &n, size_t limit = (size_t)-1, size_t offset = 0){
+    ifstream file(f, ios::binary | ios::ate);
+    if (!file || (size_t)file.tellg() < offset) return nullptr;
+    n = min((size_t)file.tellg() - offset, limit);
+    file.seekg(offset);
+    uint8_t *buf = (uint8_t *)malloc(n + 1);
+    if (buf && !file.read((char *)buf, n)){
+      free(buf);
+      buf = nullptr;
+    }
+    if (buf) buf[n] = 0;
+    return buf;
+  }//loadBytes
+
+  static bool saveBytes(const char *f, const uint8_t *buf, size_t n, const char *mode = "w"){
+    if (*mode == 'a'){
+      ofstream file(f, ios::binary | ios::app);
+      file.write((const char *)buf, n);
+      file.close();
+      return !file.fail();
+    }
+    //write a temporary file and rename it over f; f is always either the old or the new version
+    string temp = string(f) + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(buf, 1, n, file) == n && !fflush(file) && !fsync(fileno(file));
+    ok = !fclose(file) && ok && !rename(temp.c_str(), f);
+    if (!ok){
+      ::remove(temp.c_str());
+      return false;
+    }
+    string directory(f);
+    directory = directory.substr(0, directory.find_last_of('/') + 1);
+    int d = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (d >= 0){
+      fsync(d); //make the rename itself durable
+      close(d);
+    }
+    return true;
+  }//saveBytes
+
+  static void recoverFile(const char *){} //rename() replaces f in one step, so there is nothing to recover
+
+  static bool removeFile(const char *f){
+    return !::remove(f) || errno == ENOENT;
+  }
+#endif
+
+  template <class T> static uint8_t *binPut(uint8_t *p, const T &v){
+    memcpy(p, &v, sizeof v);
+    return p + sizeof v;
+  }
+  static uint8_t *binPut(uint8_t *p, const String &s){
+    uint16_t n = s.length();
+    memcpy(p, &n, 2);
+    memcpy(p + 2, s.c_str(), n + 1);
+    return p + n + 3;
+  }
+  template <class T> static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, T &v){
+    if (!p || p + sizeof v > end) return nullptr;
+    memcpy(&v, p, sizeof v);
+    return p + sizeof v;
+  }
+  static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, String &s){
+    uint16_t n;
+    if (!(p = binGet(p, end, n)) || p + n >= end || p[n]) return nullptr;
+    s = (const char *)p;
+    return p + n + 1;
+  }
+  template <class T> static size_t binSize(const T &v){
+    return sizeof v;
+  }
+  static size_t binSize(const String &s){
+    return s.length() + 3;
+  }
+)";
+  if (hasTextBuffers()) text += R"(  template <size_t N> static uint8_t *binPut(uint8_t *p, const char (&s)[N]){
+    uint16_t n = strlen(s);
+    memcpy(p, &n, 2);
+    memcpy(p + 2, s, n + 1);
+    return p + n + 3;
+  }
+  template <size_t N> static const uint8_t *binGet(const uint8_t *p, const uint8_t *end, char (&s)[N]){
+    uint16_t n;
+    if (!(p = binGet(p, end, n)) || n >= N || p + n >= end || p[n]) return nullptr;
+    memcpy(s, p, n + 1);
+    return p + n + 1;
+  }
+  template <size_t N> static size_t binSize(const char (&s)[N]){
+    return strlen(s) + 3;
+  }
+)";
+  return text;
+}
+
+/**
+ * @brief Make the text of the packed binary format functions (-b option).
+ * File layout: "J2SB", schema hash, crc32 of the json settings file, payload length, payload, crc32 of everything before it.
+ * The payload is the persisted fields in struct order, less those kept in <FILE> subtrees.
+ * readBinary() turns the file down if the json file has been changed since, so an uploaded settings file is not ignored.
+ */
+string makeBinaryFunctionText(){
+  int fixedBytes = 0, longs = 0, doubles = 0; //bools and string overheads are fixed
+  string stringLengths;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f) || f.file >= 0) continue;
+    if (f.type == "bool") fixedBytes++;
+    else if (f.type == "long") longs++;
+    else if (integerType(f.type)) fixedBytes += integerType(f.type)->size;
+    else if (f.type == "uint32_t") fixedBytes += 4;
+    else if (!f.enumNames.empty()) fixedBytes++;
+    else if (f.type == "double") doubles++;
+    else if (f.type == "String"){
+      stringLengths += " + " + (f.maxLength ? "strlen(this->" + f.path + ")" : "this->" + f.path + ".length()");
+      fixedBytes += 3; //length and terminator
+    }
+  }
+
+  string text = R"(
+  String binFilename(){
+    return String(this->filename) + ".bin";
+  }
+
+#ifdef Arduino_h
+  static uint32_t fileCrc(const char *f){ //0 if there is no such file
+    File file = SPIFFS.open(f, "r");
+    if (!file) return 0;
+    uint8_t block[128];
+    uint32_t crc = 0;
+    for (size_t n; (n = file.read(block, sizeof block)) > 0;) crc = crc32(block, n, crc);
+    file.close();
+    return crc;
+  }
+#else
+  static uint32_t fileCrc(const char *f){ //0 if there is no such file
+    ifstream file(f, ios::binary);
+    char block[4096];
+    uint32_t crc = 0;
+    while (file.read(block, sizeof block) || file.gcount()) crc = crc32((const uint8_t *)block, file.gcount(), crc);
+    return crc;
+  }
+#endif
+
+  bool writeBinary(){
+)";
+  if (!lazies.empty()) text += "    if (!this->loadLazy()) return false;\n";
+  text += R"(    size_t n = 20 + )";
+  text += to_string(fixedBytes) + " + " + to_string(longs) + " * sizeof(long) + " + to_string(doubles) + " * sizeof(double)" + stringLengths + ";\n";
+  text += R"(    uint8_t *buf = (uint8_t *)malloc(n);
+    if (!buf) return false;
+    uint8_t *p = buf;
+    memcpy(p, "J2SB", 4);
+    p = binPut(p + 4, (uint32_t))";
+  text += schemaHashText();
+  text += R"();
+    p = binPut(p, fileCrc(this->filename));
+    p = binPut(p, (uint32_t)(n - 20));
+)";
+  for (const FIELD& f : fields){
+    if (!isPersisted(f) || f.file >= 0) continue;
+    text += "    p = binPut(p, this->" + f.path + ");\n";
+  }
+  text += R"(    binPut(p, crc32(buf, n - 4));
+    bool ok = saveBytes(binFilename().c_str(), buf, n);
+    free(buf);
+    return ok;
+  }//writeBinary
+
+  int readBinary(){
+    size_t n;
+    uint8_t *buf = loadBytes(binFilename().c_str(), n);
+    if (!buf) return READ_FILE_NOT_FOUND;
+    uint32_t schema = 0, json = 0, length = 0, crc = 0;
+    if (n >= 20 && !memcmp(buf, "J2SB", 4)){
+      memcpy(&schema, buf + 4, 4);
+      memcpy(&json, buf + 8, 4);
+      memcpy(&length, buf + 12, 4);
+      memcpy(&crc, buf + n - 4, 4);
+    }
+    if (length != n - 20 || crc != crc32(buf, n - 4)){
+      free(buf);
+      return READ_PARSE_FAIL;
+    }
+    if (json != fileCrc(this->filename)){ //the json file was replaced since; it is the newer
+      free(buf);
+      return READ_VERSION_NO_MATCH;
+    }
+    const uint8_t *p = buf + 16, *end = buf + n - 4;
+    if (schema != )";
+  text += schemaHashText();
+  text += R"(){
+      free(buf);
+      return READ_VERSION_NO_MATCH;
+    }
+)";
+  for (const FIELD& f : fields){
+    if (!isPersisted(f) || f.file >= 0) continue;
+    if (isBitfield(f)) text += "    { bool bit = false; p = binGet(p, end, bit); this->" + f.path + " = bit; }\n";
+    else text += "    p = binGet(p, end, this->" + f.path + ");\n";
+  }
+  text += R"(    free(buf);
+    return p == end ? READ_OK : READ_PARSE_FAIL;
+  }//readBinary
+)";
+  return text;
+}
+
+/**
+ * @brief Make the text of the <LAZY> object functions. read() calls skipLazy() on the settings file text before parsing it:
+ * each lazy object's range is noted and blanked to an empty object, so the parser hardly sees it. loadLazy(i) later reads
+ * just that range back from the file and parses it; the accessor (eg: getLocalServers()) does so on first use. Anything
+ * that needs every field - write(), writeBinary(), submit(), getValuesScript() and the setters - loads them first.
+ * A range is only cleared once it has been parsed: an object that fails to load is tried again next time, and write()
+ * and writeBinary() fail rather than save its defaults over the settings in the file.
+ */
+string makeLazyFunctionText(){
+  string n = to_string(lazies.size());
+  string text = R"(
+  struct LAZYRANGE {
+    uint32_t offset, length; //of the object's json in the settings file; length is 0 once it has been loaded
+  } lazyRanges[)" + n + R"(] = {};
+
+  static const char *jsonSkipSpace(const char *p){
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+  }
+
+  static const char *jsonSkipValue(const char *p){ //p at the start of a value; returns the end of it or nullptr
+    int depth = 0;
+    for (;; p++){
+      switch (*p){
+        case 0: return nullptr;
+        case '"':
+          for (p++; *p != '"'; p++){
+            if (!*p) return nullptr;
+            if (*p == '\\' && p[1]) p++;
+          }
+          if (!depth) return p + 1;
+          break;
+        case '{': case '[': depth++; break;
+        case '}': case ']':
+          if (!depth) return p; //end of a number, true, false or null
+          if (!--depth) return p + 1;
+          break;
+        case ',':
+          if (!depth) return p;
+          break;
+      }
+    }
+  }
+
+  static const char *jsonFindMember(const char *p, const char *key){ //p at the '{' of an object; returns the start of key's value or nullptr
+    size_t n = strlen(key);
+    for (p = jsonSkipSpace(p + 1); *p == '"'; p = jsonSkipSpace(p)){
+      const char *name = p + 1;
+      p = jsonSkipValue(p);
+      if (!p) return nullptr;
+      bool found = (size_t)(p - 1 - name) == n && !strncmp(name, key, n);
+      p = jsonSkipSpace(p);
+      if (*p != ':') return nullptr;
+      p = jsonSkipSpace(p + 1);
+      if (found) return p;
+      p = jsonSkipValue(p);
+      if (!p) return nullptr;
+      p = jsonSkipSpace(p);
+      if (*p == ',') p++;
+    }
+    return nullptr;
+  }
+
+  static void skipLazy(char *json, LAZYRANGE *ranges){
+    const char *p, *end;
+)";
+  for (size_t i = 0; i < lazies.size(); i++){
+    string index = to_string(i);
+    vector<string> keys;
+    boost::split(keys, lazies[i].path, boost::is_any_of("."));
+    text += "    ranges[" + index + "].length = 0;\n";
+    text += "    p = jsonSkipSpace(json);\n";
+    for (const string& key : keys) text += "    if (*p == '{') p = jsonFindMember(p, \"" + key + "\");\n    if (!p) p = \"\";\n";
+    text += "    end = *p == '{' ? jsonSkipValue(p) : nullptr;\n";
+    text += "    if (end){\n";
+    text += "      ranges[" + index + "].offset = p - json;\n";
+    text += "      ranges[" + index + "].length = end - p;\n";
+    text += "      memset(json + ranges[" + index + "].offset + 1, ' ', ranges[" + index + "].length - 2);\n";
+    text += "    }\n";
+  }
+  text += "  }//skipLazy\n";
+
+  text += R"(
+  bool loadLazy(int i){ //false if the object couldn't be loaded
+    LAZYRANGE range = this->lazyRanges[i];
+    if (!range.length) return true;
+    size_t n;
+)";
+  if (makeSlots){
+    text += "    int8_t slot = this->slotState(this->filename).newest; //the slot read() parsed\n";
+    text += "    String f = slot < 0 ? String(this->filename) : slotFilename(this->filename, slot);\n";
+    text += "    char *json = (char *)loadBytes(f.c_str(), n, range.length, range.offset + (slot < 0 ? 0 : SLOT_HEADER));\n";
+  }
+  else text += "    char *json = (char *)loadBytes(String(this->filename).c_str(), n, range.length, range.offset);\n";
+  text += R"(    if (!json) return false;
+    DynamicJsonBuffer jb(JSON_BUF_SIZE);
+    JsonObject &root = jb.parseObject(json);
+    bool ok = n == range.length && root.success();
+    if (ok) switch (i){
+)";
+  for (size_t i = 0; i < lazies.size(); i++){
+    string statements = lazies[i].readFunctionText;
+    boost::replace_all(statements, lazies[i].squaredName, "root"); //the object is the root of its range
+    boost::replace_all(statements, "\n    ", "\n        ");
+    statements = "    " + statements;
+    text += "      case " + to_string(i) + ":\n";
+    text += statements;
+    text += "        break;\n";
+  }
+  text += R"(    }
+    free(json);
+    if (ok) this->lazyRanges[i].length = 0; //tried again next time otherwise
+    return ok;
+  }//loadLazy
+
+  bool loadLazy(){
+    bool ok = true;
+    for (int i = 0; i < )" + n + R"(; i++) ok = this->loadLazy(i) && ok;
+    return ok;
+  }
+)";
+  return text;
+}
+
+/**
+ * @brief Make the text of the accessors of the objects tagged <LAZY> (eg: getLocalServers()). Those read by read() after all
+ * (see EAGERLAZY) just return the object, or load the <LAZY> object they are inside.
+ */
+string makeLazyAccessorText(){
+  string text;
+  auto accessor = [&text](const string& path, int lazy, const string& comment){
+    string type = boost::to_upper_copy(path);
+    boost::replace_all(type, ".", "::");
+    text += "\n  " + type + " &get" + camelName(path) + "(){ //<LAZY>" + comment + "\n";
+    if (lazy >= 0) text += "    this->loadLazy(" + to_string(lazy) + ");\n";
+    text += "    return this->" + path + ";\n";
+    text += "  }\n";
+  };
+  for (size_t i = 0; i < lazies.size(); i++) accessor(lazies[i].path, i, ": loaded on first use");
+  for (const EAGERLAZY& e : eagerLazies) accessor(e.path, e.lazy, e.lazy >= 0 ? ": loaded with the object it is in" : " ignored: read by read()");
+  return text;
+}
+
+/**
+ * @brief Make the text of JSONTEXT, which IN() fills when the settings file is read into memory rather than parsed from a stream
+ * (-a option and <LAZY> objects).
+ */
+string makeJsonTextStructText(){
+  return R"(
+  struct JSONTEXT { //a settings file loaded into memory; json is 0 terminated
+    char *json = nullptr;
+    size_t length = 0;
+    operator bool() const { return json != nullptr; }
+    void close(){
+      free(this->json);
+      this->json = nullptr;
+    }
+    ~JSONTEXT(){ free(this->json); }
+  };
+)";
+}
 
-map<string,vector<string>> commentsNew; // holds identifier/comment pairs - multiple comments per id are possible as ids are not unique if in different objects
-// map<string,vector<string>> dataTypes;   // holds identifier/dataype pairs - ditto
+/**
+ * @brief Make the text of BLOCKREADER, the stream IN() opens when the settings file is parsed from a stream rather than from memory.
+ * ArduinoJson takes a character a call from a stream; a File would make each a SPIFFS read and an ifstream each a sentry and a
+ * get(). BLOCKREADER hands them out of a READ_BUF_SIZE buffer instead, and on the host maps the file into memory when it can.
+ */
+string makeBlockReaderText(){
+  return R"(
+#ifdef Arduino_h
+  class BLOCKREADER : public Stream { //a settings file read READ_BUF_SIZE bytes at a time
+    File file;
+    uint8_t block[READ_BUF_SIZE];
+    size_t next = 0, end = 0;
+    bool fill(){ //false at the end of the file
+      if (this->next < this->end) return true;
+      this->next = 0;
+      this->end = this->file ? this->file.read(this->block, sizeof this->block) : 0;
+      return this->end > 0;
+    }
+  public:
+    BLOCKREADER(File f) : file(f) {}
+    operator bool() const { return this->file; }
+    void close(){ this->file.close(); }
+    int available(){ return this->end - this->next + (this->file ? this->file.available() : 0); }
+    int read(){ return this->fill() ? this->block[this->next++] : -1; }
+    int peek(){ return this->fill() ? this->block[this->next] : -1; }
+    size_t readBytes(char *buffer, size_t length){ //what ArduinoJson calls, for a character at a time
+      size_t n = 0;
+      while (n < length && this->fill()){
+        size_t chunk = length - n < this->end - this->next ? length - n : this->end - this->next;
+        memcpy(buffer + n, this->block + this->next, chunk);
+        this->next += chunk;
+        n += chunk;
+      }
+      return n;
+    }
+    size_t write(uint8_t){ return 0; }
+    template <typename JSONBUFFER> JsonObject &parseObject(JSONBUFFER &jb){ return jb.parseObject((Stream &)*this); }
+  };
+#else
+  //the parser reads a mapped file as text, with no istream::get() a character; the page's slack past the end is the terminating 0
+  struct BLOCKS : streambuf { //a settings file mapped into memory, or failing that read READ_BUF_SIZE bytes at a time
+    int fd = -1;
+    char *mapped = nullptr;
+    size_t length = 0;
+    char block[READ_BUF_SIZE];
+    bool open(const char *f){
+      struct stat s;
+      if ((this->fd = ::open(f, O_RDONLY)) < 0) return false;
+      if (fstat(this->fd, &s) || s.st_size <= 0 || s.st_size % sysconf(_SC_PAGESIZE) == 0) return true; //read() it instead
+      void *p = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+      if (p == MAP_FAILED) return true;
+      this->mapped = (char *)p;
+      this->length = s.st_size;
+      setg(this->mapped, this->mapped, this->mapped + this->length);
+      return true;
+    }
+    void close(){
+      if (this->mapped) munmap(this->mapped, this->length);
+      if (this->fd >= 0) ::close(this->fd);
+      this->mapped = nullptr;
+      this->fd = -1;
+      setg(nullptr, nullptr, nullptr);
+    }
+    int_type underflow(){ //only when the file isn't mapped
+      ssize_t n = this->mapped || this->fd < 0 ? 0 : ::read(this->fd, this->block, sizeof this->block);
+      if (n <= 0) return traits_type::eof();
+      setg(this->block, this->block, this->block + n);
+      return traits_type::to_int_type(*gptr());
+    }
+  };
+  struct BLOCKSBASE { //a base of BLOCKREADER ahead of istream, so blocks is built before istream is handed it
+    BLOCKS blocks;
+  };
+  class BLOCKREADER : private BLOCKSBASE, public istream {
+  public:
+    BLOCKREADER(const char *f) : BLOCKSBASE(), istream(&this->blocks) {
+      if (!this->blocks.open(f)) setstate(ios::failbit);
+    }
+    void close(){ this->blocks.close(); }
+    ~BLOCKREADER(){ this->blocks.close(); }
+    template <typename JSONBUFFER> JsonObject &parseObject(JSONBUFFER &jb){ //strings are copied into jb, so nothing points into the mapping
+      return this->blocks.mapped ? jb.parseObject((const char *)this->blocks.mapped) : jb.parseObject((istream &)*this);
+    }
+  };
+#endif
+)";
+}
 
 /**
- * @brief Retrieve the first (front) comment for the given key. Copy it. Delete the front comment. Return the copy.
- * @warn Must only be called once per key per line during parsing. (Effectively treats commentsNew as a FIFO.)
+ * @brief Make the text of the A/B slot functions (-a option).
+ * The json settings are kept in two files, settings.filename + ".0" and ".1", each starting with a fixed size header
+ * holding a generation counter, the json length and its crc32. write() always replaces the slot that isn't the newest
+ * valid one, so a power cut part way through a write leaves the previous settings intact.
+ * read() looks at both headers and checks the crc of the newest slot; the other is only loaded if that fails.
+ * Each <FILE> subtree has slots of its own.
  */
-const string popFirstComment(const char* key){
-  string retval(commentsNew[key].front()); 
-  commentsNew[key].erase(commentsNew[key].begin());
-  return retval;
+string makeSlotFunctionText(){
+  string text = R"(
+  struct SLOTSTATE {
+    int8_t newest = -2;       //slot holding the newest valid copy; -1 if neither is valid, -2 if not looked yet
+    uint32_t generation = 0;  //generation of the newest slot
+  } slotStates[)" + to_string(1 + subtrees.size()) + R"(]; //one per settings file, see slotState()
+
+  static String slotFilename(const String &f, int slot){
+    return String(f) + (slot ? ".1" : ".0");
+  }
+
+  static bool slotHeader(const char *header, uint32_t &generation, uint32_t &length, uint32_t &crc){
+    char *end;
+    if (strncmp(header, "J2SA ", 5)) return false;
+    generation = strtoul(header + 5, &end, 16);
+    length = strtoul(end, &end, 16);
+    crc = strtoul(end, &end, 16);
+    return end == header + SLOT_HEADER - 1 && *end == '\n';
+  }
+
+  void loadSlot(const String &f, JSONTEXT &slot){
+    SLOTSTATE &state = this->slotState(f);
+    uint32_t generation[2] = {0, 0}, length, crc;
+    bool present[2];
+    for (int i = 0; i < 2; i++){
+      size_t n;
+      char *header = (char *)loadBytes(slotFilename(f, i).c_str(), n, SLOT_HEADER);
+      present[i] = header && slotHeader(header, generation[i], length, crc);
+      free(header);
+    }
+    int newest = present[1] && (!present[0] || generation[1] > generation[0]) ? 1 : 0;
+    state.newest = -1;
+    state.generation = max(generation[0], generation[1]);
+    for (int i : {newest, 1 - newest}){
+      if (!present[i]) continue;
+      size_t n;
+      char *buf = (char *)loadBytes(slotFilename(f, i).c_str(), n);
+      if (buf && slotHeader(buf, generation[i], length, crc) && length == n - SLOT_HEADER && crc == crc32((uint8_t *)buf + SLOT_HEADER, length)){
+        memmove(buf, buf + SLOT_HEADER, length + 1);
+        slot.json = buf;
+        slot.length = length;
+        state.newest = i;
+        return;
+      }
+      free(buf);
+    }
+    //neither slot is valid; an old plain settings file perhaps?
+    slot.json = (char *)loadBytes(String(f).c_str(), slot.length);
+  }//loadSlot
+
+  bool saveSlot(const String &f, char *buf, size_t length){ //buf is SLOT_HEADER bytes of space followed by the json
+    SLOTSTATE &state = this->slotState(f);
+    if (state.newest == -2){
+      JSONTEXT slot;
+      this->loadSlot(f, slot);
+    }
+    int target = state.newest == 0 ? 1 : 0;
+    uint32_t generation = state.generation + 1;
+    char header[SLOT_HEADER + 1];
+    snprintf(header, sizeof header, "J2SA %08x %08x %08x\n", (unsigned)generation, (unsigned)length, (unsigned)crc32((uint8_t *)buf + SLOT_HEADER, length));
+    memcpy(buf, header, SLOT_HEADER);
+    if (!saveBytes(slotFilename(f, target).c_str(), (uint8_t *)buf, SLOT_HEADER + length)) return false;
+    state.newest = target;
+    state.generation = generation;
+    return true;
+  }//saveSlot
+)";
+  text += "\n  SLOTSTATE &slotState(const String &" + string(subtrees.empty() ? "" : "f") + "){\n";
+  for (size_t i = 0; i < subtrees.size(); i++){
+    text += "    if (f == \"" + subtrees[i].filename + "\") return this->slotStates[" + to_string(i + 1) + "];\n";
+  }
+  text += "    return this->slotStates[0];\n";
+  text += "  }//slotState\n";
+  return text;
 }
 
 /**
- * @brief Retrieve the first (front) datatype for the given key. Copy it. Delete the front comment. Return the copy.
- * @warn Must only be called once per key per line during parsing. (Effectively treats dataTypes as a FIFO.)
+ * @brief Make the text of the journal functions (-j option).
+ * Journal layout: "J2SJ", schema hash, then records of field id, value length, value (as binPut()) and crc32 of the record.
+ * writeDirty() appends a record per dirty field; write() stays the full write, so a change made without a setter isn't lost,
+ * and it compacts: folds the records into the settings file, which saveBytes() replaces whole, and removes the journal.
+ * Before compacting, write() appends a record of every field, so a journal left behind by a power cut during compaction
+ * replays to the values already in the new settings file. A journal that hasn't been checked by read(), or is damaged, or
+ * can't be appended to, is removed before compacting instead.
+ * Replay stops at the first damaged record; the next writeDirty() compacts because anything appended after it would be lost.
+ * It returns whether every field was replayed, as it is after a write() that was compacting, so read() can do without a
+ * settings file that is missing or can't be parsed. Fields in <FILE> subtrees have files of their own and are never journalled.
  */
-// const string popFirstDataType(const char* key){
-//   string retval(dataTypes[key].front()); 
-//   dataTypes[key].erase(dataTypes[key].begin());
-//   return retval;
-// }
+string makeJournalFunctionText(){
+  vector<uint32_t> masks; //of the journalled fields
+  int persisted = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    if (persisted % 32 == 0) masks.push_back(0);
+    if (f.file < 0) masks.back() |= 1u << persisted % 32;
+    persisted++;
+  }
+  int words = masks.size();
+  string complete;
+  for (size_t i = 0; i < masks.size(); i++){
+    if (!masks[i]) continue;
+    char mask[12];
+    snprintf(mask, sizeof mask, "0x%08Xu", masks[i]);
+    complete += string(complete.empty() ? "" : " && ") + "(replayed[" + to_string(i) + "] & " + mask + ") == " + mask;
+  }
+  if (complete.empty()) complete = "false";
+  string text = R"(
+  size_t journalBytes = (size_t)-1; //journal file size; (size_t)-1 if read() hasn't checked it or found it damaged
 
-void makeValuesFunctionText(string valueName, bool isCheckBox, bool needsQuotes){
-  // if  isCheckbox == true
-  // add line retval += String("document.getElementById('router.SSID').checked = ") + "'" + String(this->router.SSID) + "'" + ";\n";
-  // eg: if dottedName is "router.SSID",
-  // add line retval += String("values['router.SSID'] = ") + "'" + String(this->router.SSID) + "'" + ";\n";
-  
-  // clog << "makeValuesFunctionText: valueName = " << valueName << endl;
-  if (isCheckBox){
-    valuesFunctionText += R"(    retval += String("document.getElementById(')";
-    valuesFunctionText += valueName;
-    valuesFunctionText += R"(').checked = "))";
-    valuesFunctionText += R"( + String(this->)"; 
-    valuesFunctionText += valueName;
-    valuesFunctionText += ")";
-    valuesFunctionText += R"( + ";\n";)";
-    valuesFunctionText += "\n";
+  String journalFilename(){
+    return String(this->filename) + ".jnl";
   }
-  else{
-    valuesFunctionText += R"(    retval += String("values[')";
-    valuesFunctionText += valueName;
-    valuesFunctionText += R"('] = "))";
-    if (needsQuotes) valuesFunctionText += R"( + "'")";
-    valuesFunctionText += R"( + String(this->)";
-    valuesFunctionText += valueName;
-    valuesFunctionText += ")";
-    if (needsQuotes) valuesFunctionText += R"( + "'")";
-    valuesFunctionText += R"( + ";\n";)";
-    valuesFunctionText += "\n";
+
+  template <class T> static uint8_t *journalPut(uint8_t *p, uint16_t id, const T &v){
+    uint8_t *record = p;
+    p = binPut(p, id);
+    p = binPut(p, (uint16_t)binSize(v));
+    p = binPut(p, v);
+    return binPut(p, crc32(record, p - record));
   }
-  //retval += String("values['weather.publishDataPeriodMs'] = " ) + String(this->weather.publishDataPeriodMs) + ";\n";
-  //clog << retval << endl;
+
+  bool writeDirty() { //only what the setters changed
+    if (this->journalBytes == (size_t)-1 || !this->appendJournal(false)) return this->write();
+    this->clearDirty();
+    return this->journalBytes <= JOURNAL_COMPACT_BYTES || this->write();
+  }//writeDirty
+
+  bool appendJournal(bool everything){ //a record per dirty field, or per field
+    size_t n = 0;
+)";
+  int bit = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    if (f.file < 0) text += "    if (everything || this->dirty[" + to_string(bit / 32) + "] & 1u << " + to_string(bit % 32) + ") n += 8 + binSize(this->" + f.path + ");\n";
+    bit++;
+  }
+  text += R"(    if (!n) return true;
+    if (!this->journalBytes) n += 8;
+    uint8_t *buf = (uint8_t *)malloc(n);
+    if (!buf) return false;
+    uint8_t *p = buf;
+    if (!this->journalBytes){
+      memcpy(p, "J2SJ", 4);
+      p = binPut(p + 4, (uint32_t))";
+  text += schemaHashText();
+  text += R"();
+    }
+)";
+  bit = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    if (f.file < 0) text += "    if (everything || this->dirty[" + to_string(bit / 32) + "] & 1u << " + to_string(bit % 32) + ") p = journalPut(p, " + to_string(bit) + ", this->" + f.path + ");\n";
+    bit++;
+  }
+  text += R"(    bool ok = saveBytes(journalFilename().c_str(), buf, n, "a");
+    free(buf);
+    if (ok) this->journalBytes += n;
+    return ok;
+  }//appendJournal
+
+  bool replayJournal(){ //true if every field was replayed
+    size_t n;
+    uint8_t *buf = loadBytes(journalFilename().c_str(), n);
+    this->journalBytes = 0;
+    if (!buf) return false;
+    this->journalBytes = n;
+    uint32_t replayed[)" + to_string(words) + R"(] = {0};
+    uint32_t schema = 0;
+    if (n >= 8 && !memcmp(buf, "J2SJ", 4)) memcpy(&schema, buf + 4, 4);
+    const uint8_t *p = buf + 8, *end = buf + n;
+    if (schema != )";
+  text += schemaHashText();
+  text += R"() p = nullptr;
+    while (p && p < end){
+      uint16_t id, length;
+      uint32_t crc;
+      if (!binGet(binGet(p, end, id), end, length) || !binGet(p + 4 + length, end, crc) || crc != crc32(p, 4 + length)){
+        p = nullptr;
+        break;
+      }
+      const uint8_t *value = p + 4, *valueEnd = value + length;
+      switch (id){
+)";
+  bit = 0;
+  for (const FIELD& f : fields){
+    if (!isPersisted(f)) continue;
+    if (f.file < 0 && isBitfield(f)) text += "        case " + to_string(bit) + ": { bool bit = false; value = binGet(value, valueEnd, bit); this->" + f.path + " = bit; } break;\n";
+    else if (f.file < 0) text += "        case " + to_string(bit) + ": value = binGet(value, valueEnd, this->" + f.path + "); break;\n";
+    bit++;
+  }
+  text += R"(        default: value = nullptr;
+      }
+      p = value == valueEnd ? valueEnd + 4 : nullptr;
+      if (p) replayed[id / 32] |= 1u << id % 32;
+    }
+    if (!p) this->journalBytes = (size_t)-1; //damaged or from another version
+    free(buf);
+    return )" + complete + R"(;
+  }//replayJournal
+)";
+  return text;
 }
 
 /**
  * @brief Write struct and html statements for the given JsonObject
+ * The read and write statements go to the functions of the main settings file or, inside a <FILE> object, to those of its subtree.
  * @warn Recursive function
  */
 void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
- const bool parentIsPrivate = false, const bool parentIsReadOnly = false,
- string fullValueName = "", string fullSquaredName="root", string fullDottedName = "this->"){
+ const bool parentIsPrivate = false, const bool parentIsReadOnly = false, const bool parentIsVolatile = false, const int parentMaxLength = 0,
+ string fullValueName = "", string fullSquaredName="root", string fullDottedName = "this->", const int file = -1, const int lazy = -1){
 
 	char definition[20] = "";
   string asType;
+  string &writeFunctionText = file < 0 ? ::writeFunctionText : subtrees[file].writeFunctionText;
+  string &readFunctionText = file >= 0 ? subtrees[file].readFunctionText : lazy >= 0 ? lazies[lazy].readFunctionText : ::readFunctionText;
+  vector<LAYOUTMEMBER> members; //declared once they're sorted (-l option)
+  string fingerprintText, equalsText; //of the persisted members, for fingerprint() and operator==
 	for (JsonPair &p : jo)
 	{
+    ostringstream declaration;
+    LAYOUTMEMBER member;
     string theComment = popFirstComment(p.key);
     string tooltipText = theComment;
     boost::replace_all(tooltipText, R"(//)", ""); //remove slashes from comment for tooltip text
     bool elementIsPrivate = ( tooltipText.find("<PRIVATE>") != string::npos );
-    bool elementIsReadOnly = ( tooltipText.find("<READONLY>") != string::npos );
+    bool elementIsConst = ( tooltipText.find("<CONST>") != string::npos );
+    if (elementIsConst) boost::replace_all(tooltipText, R"(<CONST>)", ""); //remove <CONST> from comment for tooltip text
+    bool elementIsReadOnly = ( tooltipText.find("<READONLY>") != string::npos ) || elementIsConst;
 		if (elementIsReadOnly) boost::replace_all(tooltipText, R"(<READONLY>)", ""); //remove <READONLY> from comment for tooltip text
+    bool elementIsVolatile = ( tooltipText.find("<VOLATILE>") != string::npos ) || parentIsVolatile;
+    if (elementIsVolatile) boost::replace_all(tooltipText, R"(<VOLATILE>)", ""); //remove <VOLATILE> from comment for tooltip text
+    int elementMaxLength = parentMaxLength;
+    size_t maxLengthTag = tooltipText.find("<MAXLEN");
+    if (maxLengthTag != string::npos){
+      size_t end = tooltipText.find('>', maxLengthTag);
+      elementMaxLength = atoi(tooltipText.substr(maxLengthTag + 7, end - maxLengthTag - 7).c_str());
+      if (elementMaxLength <= 0) elementMaxLength = 60; //as the html form's maxlength
+      tooltipText.erase(maxLengthTag, end == string::npos ? string::npos : end + 1 - maxLengthTag); //remove <MAXLEN n> from comment for tooltip text
+    }
+    bool isIpv4 = tooltipText.find("<IPV4>") != string::npos;
+    if (isIpv4) boost::replace_all(tooltipText, R"(<IPV4>)", ""); //remove <IPV4> from comment for tooltip text
+    int scale = 0;
+    size_t decimalTag = tooltipText.find("<DECIMAL");
+    if (decimalTag != string::npos){
+      size_t end = tooltipText.find('>', decimalTag);
+      scale = atoi(tooltipText.substr(decimalTag + 8, end - decimalTag - 8).c_str());
+      if (scale < 1 || scale > 9) clog << "Ignoring <DECIMAL> on " << p.key << ": the scale must be 1 to 9." << endl;
+      tooltipText.erase(decimalTag, end == string::npos ? string::npos : end + 1 - decimalTag); //remove <DECIMAL scale> from comment for tooltip text
+    }
+    vector<string> enumNames;
+    bool isEnum = takeEnumTag(tooltipText, enumNames); //remove <ENUM a|b|c> from comment for tooltip text
+    long tagMinValue = 0, tagMaxValue = 0;
+    bool integerTag = takeIntegerTag(tooltipText, tagMinValue, tagMaxValue); //remove <U8>, <RANGE a..b> etc from comment for tooltip text
+    string subtreeFilename;
+    size_t fileTag = tooltipText.find("<FILE ");
+    if (fileTag != string::npos){
+      size_t end = tooltipText.find('>', fileTag);
+      subtreeFilename = boost::trim_copy(tooltipText.substr(fileTag + 6, end - fileTag - 6));
+      tooltipText.erase(fileTag, end == string::npos ? string::npos : end + 1 - fileTag); //remove <FILE name> from comment for tooltip text
+    }
     
     if (p.value.is<JsonObject>()){
       // dataTypes[p.key].push = "obj"
@@ -164,13 +2578,49 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
       // readFunctionText += p.key;
       // readFunctionText +=  + ".";
 
-      writeFunctionText += "    "; //fixed 4 space indent :(
-      writeFunctionText += fullSquaredName;
-      if (level > 0) writeFunctionText += ".as<JsonObject>()";
-      writeFunctionText += R"(.createNestedObject(")";
-      writeFunctionText += p.key;
-      writeFunctionText += R"(");)";
-      writeFunctionText += "\n";
+      string squaredName = fullSquaredName + R"([")" + p.key + R"("])";
+      int objectFile = file;
+      int objectLazy = lazy;
+      if (tooltipText.find("<LAZY>") != string::npos){
+        boost::replace_all(tooltipText, R"(<LAZY>)", ""); //remove <LAZY> from comment for tooltip text
+        string path = fullValueName + (level>0? "." : "") + p.key;
+        if (makeJournal) clog << "Ignoring <LAZY> on " << p.key << ": the journal is replayed over every field." << endl;
+        else if (file >= 0 || !subtreeFilename.empty()) clog << "Ignoring <LAZY> on " << p.key << ": <FILE> objects have their own read function." << endl;
+        if (!makeJournal && file < 0 && subtreeFilename.empty() && lazy < 0 && !elementIsVolatile){
+          LAZY object;
+          object.path = path;
+          object.squaredName = squaredName;
+          lazies.push_back(object);
+          objectLazy = lazies.size() - 1;
+        }
+        else eagerLazies.push_back(EAGERLAZY{path, lazy}); //read with the rest, but still reached through its accessor
+      }
+      if (elementIsVolatile){
+        //nothing below is persisted
+      }
+      else if (!subtreeFilename.empty()){
+        //the object is the root of its own file
+        SUBTREE subtree;
+        subtree.path = fullValueName + (level>0? "." : "") + p.key;
+        subtree.filename = subtreeFilename;
+        subtrees.push_back(subtree);
+        objectFile = subtrees.size() - 1;
+        squaredName = "root";
+      }
+      else if (!makeTable || file >= 0){ //the field table makes the objects its fields need
+        writeFunctionText += "    "; //fixed 4 space indent :(
+        writeFunctionText += fullSquaredName;
+        if (fullSquaredName != "root") writeFunctionText += ".as<JsonObject>()";
+        writeFunctionText += R"(.createNestedObject(")";
+        writeFunctionText += p.key;
+        writeFunctionText += R"(");)";
+        writeFunctionText += "\n";
+        if (makeOverrides){ //drop the object again if none of its fields differ from their defaults; innermost first
+          string &pruneFunctionText = file < 0 ? ::pruneFunctionText : subtrees[file].pruneFunctionText;
+          string parent = fullSquaredName == "root" ? "root" : fullSquaredName + ".as<JsonObject>()";
+          pruneFunctionText = "    if (!" + squaredName + ".size()) " + parent + R"(.remove(")" + p.key + R"(");)" + "\n" + pruneFunctionText;
+        }
+      }
       // string myFullName = parentName + "[" + p.key;
       // myFullName += "]";
 
@@ -188,18 +2638,20 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
       }
 
 			JsonObject& o = p.value.as<JsonObject&>();
-			stream << std::string(level+2,' ') << "struct " ;
+      size_t readStart = readFunctionText.size(), writeStart = writeFunctionText.size(), valuesStart = valuesFunctionText.size();
+			declaration << std::string(level+2,' ') << "struct " ;
       
       //add upper case struct label
       for (int i = 0; p.key[i]; i++){
-        stream << (char)toupper(p.key[i]);
+        declaration << (char)toupper(p.key[i]);
       }
-      stream << " {" << std::endl;
+      declaration << " {" << std::endl;
 
-			iterateObject(o, stream, level + 2, elementIsPrivate || parentIsPrivate, elementIsReadOnly || parentIsReadOnly,
+			iterateObject(o, declaration, level + 2, elementIsPrivate || parentIsPrivate, elementIsReadOnly || parentIsReadOnly, elementIsVolatile, elementMaxLength,
                     fullValueName + (level>0? "." : "") + p.key,
-                    fullSquaredName + R"([")" + p.key + R"("])",
-                    fullDottedName + (level>0? "." : "") + p.key );
+                    squaredName,
+                    fullDottedName + (level>0? "." : "") + p.key,
+                    objectFile, objectLazy );
 
       if  (makeHtmlFile){
         //end table or sub table
@@ -211,11 +2663,48 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
         }
       }
 
-			stream << std::string(level+2,' ') << "}" << p.key  << ";" << std::endl; 
+			declaration << std::string(level+2,' ') << "}" << p.key  << ";" << std::endl; 
+      SHAPE shape;
+      shape.path = fullValueName + (level>0? "." : "") + p.key;
+      shape.key = p.key;
+      shape.typeName = structureLabel;
+      vector<string> keys;
+      boost::split(keys, shape.path, boost::is_any_of("."));
+      for (const string& key : keys) shape.typeName += "::" + boost::to_upper_copy(key);
+      shape.squaredName = squaredName;
+      shape.declaration = declaration.str();
+      vector<string> lines;
+      boost::split(lines, shape.declaration, boost::is_any_of("\n"));
+      for (size_t i = 1; i + 2 < lines.size(); i++) shape.shape += boost::trim_left_copy(lines[i]) + "\n"; //without struct MQTT { and }mqtt;
+      boost::replace_all(shape.shape, "(const " + boost::to_upper_copy(string(p.key)) + " &o)", "(const &o)"); //operator== takes its own type, whatever its name
+      shape.isOwnRoot = objectFile != file || objectLazy != lazy;
+      shape.file = file;
+      shape.lazy = lazy;
+      if (!shape.isOwnRoot){
+        shape.readText = readFunctionText.substr(readStart);
+        shape.writeText = writeFunctionText.substr(writeStart);
+      }
+      shape.valuesText = valuesFunctionText.substr(valuesStart);
+      shapes.push_back(shape);
+      if (!elementIsVolatile){
+        fingerprintText += string(level + 4, ' ') + "h = this->" + p.key + ".fingerprint(h);\n";
+        equalsText += string(equalsText.empty() ? "" : " && ") + "this->" + p.key + " == o." + p.key;
+      }
+      if (makeLayout){
+        member.rank = layouts.back().rank;
+        member.size = layouts.back().packedSize;
+        member.align = layouts.back().align;
+        member.sizeText = "sizeof(" + layouts.back().typeName + ")";
+      }
 		}
 		else{ //not an object
       char* fieldType;
       bool includeValueInQuotes = false;
+      int maxLength = p.value.is<char*>() ? elementMaxLength : 0;
+      if (maxLength && strlen(p.value.as<const char*>()) > (size_t)maxLength){
+        clog << "<MAXLEN " << maxLength << "> on " << p.key << " is shorter than its default; using " << strlen(p.value.as<const char*>()) << "." << endl;
+        maxLength = strlen(p.value.as<const char*>());
+      }
 			if      (p.value.is<bool>()){   strcpy(definition,"bool");   fieldType = "checkbox"; asType = "as<bool>";}
 			else if (p.value.is<long>()){   strcpy(definition,"long");   fieldType = "number"; asType = "as<long>";}
 			else if (p.value.is<double>()){ strcpy(definition,"double"); fieldType = "number"; asType = "as<double>";}
@@ -224,8 +2713,97 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
 			else {strcpy(definition,"// unknown type"); fieldType = "text";}
       // dataTypes[p.key].push_back(definition);
 
+      //narrow integers, and numeric strings so tagged, to the smallest type that holds their range
+      ostringstream value;
+      value << p.value;
+      long minValue = 0, maxValue = 0;
+      char *end = nullptr;
+      long number = p.value.is<long>() ? p.value.as<long>() : p.value.is<char*>() ? strtol(p.value.as<const char*>(), &end, 10) : 0;
+      bool isNumericString = end && end != p.value.as<const char*>() && !*end;
+      if (integerTag && (p.value.is<long>() || isNumericString)){
+        minValue = min(tagMinValue, number);
+        maxValue = max(tagMaxValue, number);
+        if (minValue != tagMinValue || maxValue != tagMaxValue) clog << "The range of " << p.key << " is widened to hold its default, " << number << "." << endl;
+      }
+      else if (integerTag) clog << "Ignoring the integer tag on " << p.key << ": it isn't an integer or a numeric string." << endl;
+      else if (inferIntegers && p.value.is<long>()){
+        const INTEGERTYPE *inferred = narrowestType(min(0L, number), max(0L, number));
+        if (inferred){ //the whole of the type, not just up to the default
+          minValue = inferred->minValue;
+          maxValue = inferred->maxValue;
+        }
+      }
+      const INTEGERTYPE *narrowType = minValue != maxValue ? narrowestType(minValue, maxValue) : nullptr;
+      if (narrowType){
+        strcpy(definition, narrowType->name);
+        fieldType = "number";
+        includeValueInQuotes = false;
+        maxLength = 0;
+        value.str(to_string(number)); //a numeric string's default becomes a number
+      }
+      else{
+        if (minValue != maxValue) clog << "Ignoring the range of " << p.key << ": it needs a long." << endl;
+        minValue = maxValue = 0;
+      }
+
+      //keep decimals, and numeric strings so tagged, as scaled longs
+      long scaled = 0;
+      bool isDecimal = scale >= 1 && scale <= 9 && !narrowType && !p.value.is<bool>() && p.value.as<const char*>(); //the number's text, as parsed
+      if (isDecimal && !parseDecimal(p.value.as<const char*>(), scale, scaled)){
+        clog << "Ignoring <DECIMAL " << scale << "> on " << p.key << ": its default isn't a decimal number that fits." << endl;
+        isDecimal = false;
+      }
+      if (isDecimal){
+        strcpy(definition, "long");
+        fieldType = "number";
+        includeValueInQuotes = false;
+        maxLength = 0;
+        value.str(to_string(scaled));
+      }
+      else scale = 0;
+
+      //keep dotted quads so tagged as uint32_t
+      uint32_t ip = 0;
+      if (isIpv4 && (!p.value.is<char*>() || narrowType || scale || !parseIpv4(p.value.as<const char*>(), ip))){
+        clog << "Ignoring <IPV4> on " << p.key << ": its default isn't a dotted quad." << endl;
+        isIpv4 = false;
+      }
+      if (isIpv4){
+        strcpy(definition, "uint32_t");
+        maxLength = 0;
+        char hex[12];
+        snprintf(hex, sizeof hex, "0x%08Xu", ip);
+        value.str(hex);
+      }
+
+      //keep strings with a few known values as an enum class, declared with the field eg: enum class MODE : uint8_t {...}
+      size_t enumIndex = find(enumNames.begin(), enumNames.end(), p.value.is<char*>() ? p.value.as<const char*>() : "") - enumNames.begin();
+      set<string> identifiers;
+      for (const string& name : enumNames) identifiers.insert(enumIdentifier(name));
+      if (isEnum && (!p.value.is<char*>() || narrowType || scale || isIpv4 || enumIndex == enumNames.size())){
+        clog << "Ignoring <ENUM> on " << p.key << ": its default isn't one of its names." << endl;
+        isEnum = false;
+      }
+      else if (isEnum && (identifiers.size() != enumNames.size() || enumNames.size() > 255)){
+        clog << "Ignoring <ENUM> on " << p.key << ": its names must be at most 255 and distinct as identifiers." << endl;
+        isEnum = false;
+      }
+      string enumLabel = boost::to_upper_copy(string(p.key)); //eg: MODE
+      string enumType = enumLabel; //as named from the settings struct eg: DEVICE::WIFI::MODE
+      if (isEnum){
+        vector<string> keys;
+        if (level > 0) boost::split(keys, fullValueName, boost::is_any_of("."));
+        for (auto key = keys.rbegin(); key != keys.rend(); ++key) enumType = boost::to_upper_copy(*key) + "::" + enumType;
+        fieldType = "select";
+        maxLength = 0;
+        value.str(to_string(enumIndex));
+      }
+      else enumNames.clear();
+
+
+      bool constText = elementIsConst && !strcmp(definition, "String"); //a constant string is a char[] holding the literal
+      if (elementIsConst) maxLength = 0;
 
-      readFunctionText += "    "; //fixed 4 space indent :(
       //replace settings.xxx with this->xxx
       //string s(fullDottedName);
       // boost::replace_all(s,"settings.","this->"); //disgusting! TODO
@@ -240,6 +2818,17 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
       dottedName += R"("].)";
       dottedName += asType;
       dottedName += R"(();)";
+      string fieldName = fullDottedName + (level > 0 ? "." : "") + p.key;
+      string variantName = fullSquaredName + R"([")" + p.key + R"("])";
+      string defaultName = defaultsName(fullValueName + (level > 0 ? "." : "") + p.key);
+      if (maxLength) dottedName = "setText(" + fieldName + ", " + variantName + ".as<const char*>());"; //copied into the buffer
+      string range = rangeText(minValue, maxValue);
+      if (narrowType) dottedName = "readInteger(" + fieldName + ", " + variantName + ", " + range + ");"; //clamped to its range
+      if (scale) dottedName = "readDecimal(" + fieldName + ", " + variantName + ", " + to_string(scale) + ");";
+      if (isIpv4) dottedName = "readIpv4(" + fieldName + ", " + variantName + ");";
+      if (isEnum) dottedName = "readEnum(" + fieldName + ", " + variantName + ");";
+      if (makeOverrides) dottedName = string(maxLength ? "readTextOrDefault(" : isIpv4 ? "readIpv4OrDefault(" : isEnum ? "readEnumOrDefault(" : "readOrDefault(") + fieldName + ", " + variantName + ", " + defaultName + (narrowType ? ", " + range : scale ? ", " + to_string(scale) : "") + ");";
+      if (makeOverrides && makeLayout && p.value.is<bool>()) dottedName = fieldName + " = valueOrDefault(" + variantName + ", " + defaultName + ");"; //a bitfield can't be bound to a reference
 
       // readFunctionText += fullDottedName;
       // if (level > 0) readFunctionText += ".";
@@ -252,26 +2841,45 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
       // readFunctionText += asType;
       // readFunctionText += R"(();)";
 
-      readFunctionText += dottedName;
-      readFunctionText += "\n";
-
-      writeFunctionText += "    "; //fixed 4 space indent :(
-      writeFunctionText += fullSquaredName;
-      writeFunctionText += R"([")";
-      writeFunctionText += p.key;
-      writeFunctionText += R"("] = )";
-      writeFunctionText += fullDottedName; 
-      if (level > 0) writeFunctionText += ".";
-      writeFunctionText += p.key;
-      writeFunctionText += ";\n"; 
+      if (elementIsConst && fieldName == "this->version"){ //written from the constant, for read() to check
+        writeFunctionText += "    " + variantName + " = " + fieldName + ";\n";
+      }
+      else if (!elementIsVolatile && !elementIsConst){ //runtime only fields are neither read nor written, nor are constants
+        if (!makeTable || lazy >= 0 || file >= 0){ //else read by readTable()
+          readFunctionText += "    "; //fixed 4 space indent :(
+          readFunctionText += dottedName;
+          readFunctionText += "\n";
+        }
+      }
+      if (!elementIsVolatile && !elementIsConst && (!makeTable || file >= 0)){ //else written by writeTable()
+        writeFunctionText += "    "; //fixed 4 space indent :(
+        if (makeOverrides && fieldName != "this->version") writeFunctionText += "if (!isDefault(" + string(isEnum ? "(uint8_t)" : "") + fieldName + ", " + defaultName + ")) ";
+        writeFunctionText += fullSquaredName;
+        writeFunctionText += R"([")";
+        writeFunctionText += p.key;
+        writeFunctionText += R"("] = )";
+        if (scale) writeFunctionText += "RawJson(formatDecimal(" + fieldName + ", " + to_string(scale) + "))"; //copied into the json buffer
+        else if (isIpv4) writeFunctionText += "formatIpv4(" + fieldName + ")"; //likewise
+        else if (isEnum) writeFunctionText += "enumName(" + fieldName + ")"; //a literal, so not copied
+        else{
+          writeFunctionText += fullDottedName; 
+          if (level > 0) writeFunctionText += ".";
+          writeFunctionText += p.key;
+        }
+        writeFunctionText += ";\n"; 
+      }
 
       string valueName = fullValueName;
 
-      if (makeValuesJsFile && !elementIsPrivate && !parentIsPrivate){  //FIXME if required when -v option is implemented
+      if (makeValuesJsFile && !elementIsPrivate && !parentIsPrivate && (!makeTable || elementIsConst)){  //FIXME if required when -v option is implemented
         //add a value eg: value['router.SSID'] = '%router.SSID%'; to secondary script file
         if (level > 0) valueName += ".";
         valueName += p.key;
-        makeValuesFunctionText(valueName, p.value.is<bool>(), includeValueInQuotes);
+        string valueText = maxLength || constText ? fieldName : narrowType ? "formatLong(number, " + fieldName + ")" : scale ? "formatDecimal(" + fieldName + ", " + to_string(scale) + ")" : isIpv4 ? "formatIpv4(" + fieldName + ")" : isEnum ? "enumName(" + fieldName + ")" : "";
+        if (valueText.empty() && !strcmp(definition, "long")) valueText = "formatLong(number, " + fieldName + ")"; //into the function's NUMBERTEXT
+        else if (valueText.empty() && !strcmp(definition, "double")) valueText = "formatDouble(number, " + fieldName + ")";
+        else if (valueText.empty() && !strcmp(definition, "String")) valueText = fieldName; //appended as it is, not copied into a String first
+        makeValuesFunctionText(valueName, p.value.is<bool>(), includeValueInQuotes, valueText);
       //below is probably redundant if we use valuesJs.js script TODO
         // initValues += R"(values[")";
         // initValues += valueName;
@@ -285,70 +2893,282 @@ void iterateObject(JsonObject& jo, std::ostream& stream, const int level = 0,
         // initValues += "\n";
       }
 
-      //snippets - webServer handle submitted form
-      if (makeSnippetFile && !elementIsPrivate && !parentIsPrivate && !elementIsReadOnly && !parentIsReadOnly){
-        string str = structureName + ".";
-        if (p.value.is<bool>()){ 
-          snippetOutput << "  " << str << valueName << R"( = webServer.hasArg(")" << valueName << R"(");)" << endl << endl;
-        }
-        else if (p.value.is<long>()){ 
-          snippetOutput << R"(  if (webServer.hasArg(")" << valueName << R"(")))" ;
-          snippetOutput << "{\n    "  << str << valueName << " = " << R"(atol(webServer.arg(")" << valueName << R"(").c_str());)" << endl << R"(  })" << endl << endl;
-        }
-        else if (p.value.is<double>()){ 
-          snippetOutput << R"(  if (webServer.hasArg(")" << valueName << R"(")))" ;
-          snippetOutput << "{\n    "  << str << valueName << " = " << R"(atof(webServer.arg(")" << valueName << R"(").c_str());)" << endl << R"(  })" << endl << endl;
-        }
-        else{
-          snippetOutput << R"(  if (webServer.hasArg(")" << valueName << R"(")))" ;
-          snippetOutput << "{\n    "  << str << valueName << " = " << R"(webServer.arg(")" << valueName << R"(");)" << endl << R"(  })" << endl << endl;
-        }
+      //remember the field for code that needs all of them at once (eg: submit())
+      FIELD field;
+      field.path = fullValueName + (level > 0 ? "." : "") + p.key;
+      field.type = isEnum ? enumType : definition;
+      field.value = value.str();
+      field.isPrivate = elementIsPrivate || parentIsPrivate;
+      field.isReadOnly = elementIsReadOnly || parentIsReadOnly;
+      field.isVolatile = elementIsVolatile;
+      field.file = file;
+      field.lazy = file < 0 ? lazy : -1;
+      field.maxLength = maxLength;
+      field.minValue = minValue;
+      field.maxValue = maxValue;
+      field.scale = scale;
+      field.isIpv4 = isIpv4;
+      field.enumNames = enumNames;
+      field.isConst = elementIsConst;
+      fields.push_back(field);
+      if (isPersisted(field)){
+        fingerprintText += string(level + 4, ' ') + "h = fingerprintOf(h, " + (isBitfield(field) ? "(bool)" : "") + "this->" + p.key + ");\n";
+        string member = "this->" + string(p.key), other = "o." + string(p.key);
+        equalsText += string(equalsText.empty() ? "" : " && ") + (maxLength ? "!strcmp(" + member + ", " + other + ")" : field.type == "double" ? "sameValue(" + member + ", " + other + ")" : member + " == " + other);
       }
 
       if (makeHtmlFile && !elementIsPrivate && !parentIsPrivate){
         //add an input field
         if (level > 0){ //inside a table - add a new row
           htmlOutput << "<tr><td><label>" << p.key << "</label></td>";
-          htmlOutput << "<td><input type='" << fieldType << "' id='" << valueName << "' name='" << valueName;
+          htmlOutput << "<td><" << (isEnum ? "select" : "input type='" + string(fieldType) + "'") << " id='" << valueName << "' name='" << valueName;
           if (!strcmp(fieldType,"checkbox")){
             if (p.value) htmlOutput << "' checked";
             else htmlOutput << "'";
           }
+          else if (isEnum) htmlOutput << "'";
           else {
-            htmlOutput << "' value=" << p.value;
+            htmlOutput << "' value=" << (scale || isIpv4 ? "\"" + string(p.value.as<const char*>()) + "\"" : value.str()); //a decimal's or address's default as written
           }
           if (insertTooltips) htmlOutput << " title='" << tooltipText <<"'";
           if (elementIsReadOnly || parentIsReadOnly){
             htmlOutput << " disabled";
           }
-          htmlOutput << " maxlength='60'></td></tr>";
+          if (narrowType) htmlOutput << " min='" << minValue << "' max='" << maxValue << "'";
+          if (scale) htmlOutput << " step='0." << string(scale - 1, '0') << "1'";
+          if (isEnum){ //an option per name, the default selected
+            htmlOutput << ">";
+            for (size_t i = 0; i < enumNames.size(); i++) htmlOutput << "<option" << (i == enumIndex ? " selected" : "") << ">" << enumNames[i] << "</option>";
+            htmlOutput << "</select></td></tr>";
+          }
+          else htmlOutput << " maxlength='" << (maxLength ? maxLength : isIpv4 ? 15 : 60) << "'></td></tr>";
         }
         else{ //outside a table - make one just for this element
           htmlOutput << "<table><tr><td><label>" << p.key << "</label></td>";
-          htmlOutput << "<td><input type='" << fieldType << "' id='" << valueName << "' name='" << valueName;
+          htmlOutput << "<td><" << (isEnum ? "select" : "input type='" + string(fieldType) + "'") << " id='" << valueName << "' name='" << valueName;
           if (!strcmp(fieldType,"checkbox")){
             if (p.value) htmlOutput << "' checked";
             else htmlOutput << "'";
           }
+          else if (isEnum) htmlOutput << "'";
           else {
-            htmlOutput << "' value=" << p.value;
+            htmlOutput << "' value=" << (scale || isIpv4 ? "\"" + string(p.value.as<const char*>()) + "\"" : value.str()); //a decimal's or address's default as written
           }
           if (insertTooltips) htmlOutput << " title='" << tooltipText <<"'";
           if (elementIsReadOnly || parentIsReadOnly){
             htmlOutput << " disabled";
           }
-          htmlOutput << " maxlength='60'></td></tr></table>";
+          if (narrowType) htmlOutput << " min='" << minValue << "' max='" << maxValue << "'";
+          if (scale) htmlOutput << " step='0." << string(scale - 1, '0') << "1'";
+          if (isEnum){ //an option per name, the default selected
+            htmlOutput << ">";
+            for (size_t i = 0; i < enumNames.size(); i++) htmlOutput << "<option" << (i == enumIndex ? " selected" : "") << ">" << enumNames[i] << "</option>";
+            htmlOutput << "</select></td></tr></table>";
+          }
+          else htmlOutput << " maxlength='" << (maxLength ? maxLength : isIpv4 ? 15 : 60) << "'></td></tr></table>";
         }
       }
 
-			stream << std::string(level+2,' ') << definition << " " << p.key << " = " << p.value << ";";
-      if (transferComments) stream << " " << theComment;
-      stream << std::endl;
+      string storage = elementIsConst ? "static constexpr " : ""; //a constant is compiled in: no String, nothing to read
+      if (isEnum){
+        declaration << std::string(level+2,' ') << "enum class " << enumLabel << " : uint8_t {";
+        for (size_t i = 0; i < enumNames.size(); i++) declaration << (i ? ", " : " ") << enumIdentifier(enumNames[i]);
+        declaration << " };" << std::endl;
+        if (!makeOverrides || elementIsConst) value.str(enumLabel + "::" + enumIdentifier(enumNames[enumIndex]));
+      }
+			if (constText) declaration << std::string(level+2,' ') << storage << "char " << p.key << "[]";
+			else if (maxLength) declaration << std::string(level+2,' ') << "char " << p.key << "[" << maxLength + 1 << "]";
+			else declaration << std::string(level+2,' ') << storage << (isEnum ? enumLabel.c_str() : definition) << " " << p.key;
+      if (isBitfield(field)){ //packed; the constructor gives it its default
+        declaration << " : 1";
+        if (!makeOverrides) bitfieldDefaultsText += "    " + fieldName + " = " + value.str() + ";\n";
+      }
+      else if (!makeOverrides || elementIsConst) declaration << " = " << value.str(); //else set from the defaults table by the constructor
+      declaration << ";";
+      if (transferComments) declaration << " " << theComment;
+      declaration << std::endl;
+      if (makeLayout) member = elementIsConst ? LAYOUTMEMBER{"", 4, 0, 1, ""} : leafLayout(isEnum ? "uint8_t" : field.type, maxLength); //a constant takes no room
 		}
+    member.declaration = declaration.str();
+    if (makeLayout) members.push_back(member);
+    else stream << member.declaration;
 	}
+  if (makeLayout){
+    string typeName = structureLabel; //eg: SETTINGS::DEVICE::WIFI
+    vector<string> keys;
+    if (level > 0) boost::split(keys, fullValueName, boost::is_any_of("."));
+    for (const string& key : keys) typeName += "::" + boost::to_upper_copy(key);
+    stream << layoutText(members, typeName);
+  }
+  string indent(level + 2, ' ');
+  string label = level > 0 ? boost::to_upper_copy(fullValueName.substr(fullValueName.rfind('.') + 1)) : structureLabel;
+  string text = indent + "uint32_t fingerprint(uint32_t h = 2166136261u) const{ //FNV-1a of the persisted fields, as loaded\n" + fingerprintText;
+  text += indent + "  return h;\n" + indent + "}\n";
+  text += indent + "bool operator==(const " + label + " &o) const{ //the persisted fields are equal\n";
+  text += indent + "  return " + (equalsText.empty() ? "true" : equalsText) + ";\n" + indent + "}\n";
+  text += indent + "bool operator!=(const " + label + " &o) const{ return !(*this == o); }\n";
+  if (level == 0 && !lazies.empty()){ //the non const overloads load the <LAZY> objects, so what has been used doesn't change the result
+    text += indent + "uint32_t fingerprint(uint32_t h = 2166136261u){ //<LAZY> objects loaded first\n";
+    text += indent + "  this->loadLazy();\n";
+    text += indent + "  return static_cast<const " + label + " &>(*this).fingerprint(h);\n" + indent + "}\n";
+    text += indent + "bool operator==(" + label + " &o){ //<LAZY> objects of both loaded first\n";
+    text += indent + "  this->loadLazy();\n" + indent + "  o.loadLazy();\n";
+    text += indent + "  return static_cast<const " + label + " &>(*this) == static_cast<const " + label + " &>(o);\n" + indent + "}\n";
+    text += indent + "bool operator!=(" + label + " &o){ return !(*this == o); }\n";
+  }
+  if (level > 0) stream << text;
+  else comparisonFunctionText = text;
 } //iterateObject
 
 
+/**
+ * @brief Make the text of the cached getValuesScript() (-m option): the script made last is kept with a fingerprint of the fields shown on the
+ * form, taken through visitFields(), and only made again once that changes. The hits and misses are counted.
+ */
+string makeValuesCacheText(){
+  string text = R"(
+  String valuesScript; //as made last by getValuesScript()
+  uint32_t valuesScriptFingerprint = 0; //of the fields shown on the form, when it was made
+  uint32_t valuesScriptHits = 0, valuesScriptMisses = 0;
+  struct SHOWNFIELDS { //adds the fields on the form to a fingerprint
+    uint32_t h;
+    template <class T> void operator()(const char *, const char *, const T &v, uint8_t flags){ if (!(flags & (FIELD_PRIVATE | FIELD_CONST))) h = fingerprintOf(h, v); }
+  };
+  const String &getValuesScript(){
+)";
+  if (!lazies.empty()) text += "    this->loadLazy();\n";
+  text += R"(    SHOWNFIELDS shown = {2166136261u};
+    this->visitFields(shown);
+    if (this->valuesScript.length() && shown.h == this->valuesScriptFingerprint) this->valuesScriptHits++;
+    else{
+      this->valuesScript = this->makeValuesScript();
+      this->valuesScriptFingerprint = shown.h;
+      this->valuesScriptMisses++;
+    }
+    return this->valuesScript;
+  }//getValuesScript
+)";
+  return text;
+}
+
+/**
+ * @brief Move the bodies of the member functions of the settings struct to the implementation file (-c option), leaving their declarations.
+ * Only functions of the struct itself are moved, and only those with bodies of their own lines: templates, static helpers, one line setters
+ * and functions with default arguments stay inline, as do the functions of nested structs. A function declared inside #if blocks (eg: the
+ * Arduino only service()) is defined inside the same ones. Returns the struct text that is left.
+ */
+string moveFunctionBodies(const string& structText, string& definitions){
+  static const regex functionStart(R"(^  ([A-Za-z_][\w:]*(?: +| *[&*] *))?(\w+)\((.*)\)( *const)? *\{ *(//.*)?$)");
+  vector<string> lines;
+  boost::split(lines, structText, boost::is_any_of("\n"));
+  string text;
+  vector<string> conditions; //the #if, #else... lines of the blocks open at line i, outermost first
+  for (size_t i = 0; i < lines.size(); i++){
+    smatch m;
+    const string& line = lines[i];
+    if (boost::starts_with(line, "#if")) conditions.push_back(line + "\n");
+    else if ((boost::starts_with(line, "#el")) && !conditions.empty()) conditions.back() += line + "\n"; //the definition goes in the same branch
+    else if (boost::starts_with(line, "#endif") && !conditions.empty()) conditions.pop_back();
+    size_t end = i + 1;
+    while (end < lines.size() && lines[end].compare(0, 3, "  }")) end++;
+    bool isMoved = regex_match(line, m, functionStart) && end < lines.size() && m[3].str().find('=') == string::npos;
+    for (const char *keyword : {"static", "template", "struct", "enum", "union", "typedef"}) isMoved = isMoved && m[1] != keyword;
+    if (!isMoved){
+      text += line + (i + 1 < lines.size() ? "\n" : "");
+      continue;
+    }
+    string returnType = boost::trim_right_copy(m[1].str());
+    string baseType = boost::trim_right_copy(boost::trim_right_copy_if(returnType, boost::is_any_of("&* ")));
+    bool isNested = !baseType.empty() && isupper(baseType[0]) && baseType != "String" && baseType.compare(0, 4, "Json"); //eg: LOCALSERVERS &
+    text += "  " + m[1].str() + m[2].str() + "(" + m[3].str() + ")" + m[4].str() + ";" + (m[5].length() ? " " + m[5].str() : "") + "\n";
+    for (const string& condition : conditions) definitions += condition;
+    definitions += (isNested ? structureLabel + "::" : "") + m[1].str() + structureLabel + "::" + m[2].str() + "(" + m[3].str() + ")" + m[4].str() + "{" + (m[5].length() ? " " + m[5].str() : "") + "\n";
+    for (size_t j = i + 1; j < end; j++) definitions += lines[j].substr(min(lines[j].size(), min<size_t>(2, lines[j].find_first_not_of(' ')))) + "\n"; //one indent less
+    definitions += lines[end].substr(2) + "\n";
+    for (size_t j = 0; j < conditions.size(); j++) definitions += "#endif\n";
+    definitions += "\n";
+    i = end + 1 < lines.size() && lines[end + 1].empty() ? end + 1 : end; //the declarations aren't spaced out as the definitions were
+  }
+  return text;
+}
+
+/**
+ * @brief Objects of the same shape - the same members, types and defaults, in the same order - share the struct of the one declared first:
+ * the others are declared with a typedef of it. Their read, write and values statements become functions of that struct, readJson(),
+ * writeJson() and appendValues(), called for each object, where the statements of every object are alike but for its place.
+ * Shapes with an enum or a constant aren't shared, as their helpers and definitions are per type; nor are objects inside a shared one.
+ */
+void shareShapes(string& structText){
+  map<string, vector<size_t>> groups;
+  for (size_t i = 0; i < shapes.size(); i++){
+    const string& shape = shapes[i].shape;
+    if (shape.empty() || shape.find("enum class ") != string::npos || shape.find("static constexpr ") != string::npos) continue;
+    groups[shape].push_back(i);
+  }
+  vector<const vector<size_t>*> sharing;
+  for (const auto& group : groups) if (group.second.size() > 1) sharing.push_back(&group.second);
+  sort(sharing.begin(), sharing.end(), [](const vector<size_t>* a, const vector<size_t>* b){ return shapes[a->front()].shape.size() > shapes[b->front()].shape.size(); }); //outermost first
+  vector<string> shared;
+  for (const vector<size_t>* group : sharing){
+    bool isInside = false;
+    for (size_t i : *group) for (const string& path : shared) isInside = isInside || boost::starts_with(shapes[i].path, path + ".");
+    if (isInside) continue;
+    size_t first = group->front();
+    for (size_t i : *group) if (structText.find(shapes[i].declaration) < structText.find(shapes[first].declaration)) first = i;
+    size_t firstAt = structText.find(shapes[first].declaration); //objects of the same name at the same depth are declared alike, so the others are looked for after it
+    string indent = shapes[first].declaration.substr(0, shapes[first].declaration.find_first_not_of(' '));
+    //the statements of each object, as they would be in a function of the struct
+    string texts[3] = {"", "", ""};
+    bool isShared[3] = {true, true, true};
+    for (size_t i : *group){
+      const SHAPE& s = shapes[i];
+      string statements[3] = {s.readText, s.writeText, s.valuesText};
+      for (int j = 0; j < 3; j++){
+        string& text = statements[j];
+        if (j < 2){
+          boost::replace_all(text, s.squaredName + ".as<JsonObject>()", "root");
+          boost::replace_all(text, s.squaredName, "root");
+        }
+        else{
+          boost::replace_all(text, "('" + s.path + ".", "('\") + prefix + String(\".");
+          boost::replace_all(text, "['" + s.path + ".", "['\") + prefix + String(\".");
+        }
+        boost::replace_all(text, "this->" + s.path + ".", "this->");
+        if (i == group->front()) texts[j] = text;
+        isShared[j] = isShared[j] && !s.isOwnRoot && !text.empty() && text == texts[j];
+      }
+    }
+    string functions;
+    const string names[3] = {"void readJson(JsonObject &root)", "void writeJson(JsonObject &root)", "void appendValues(String &retval, const char *prefix)"};
+    for (int j = 0; j < 3; j++){
+      if (!isShared[j]) continue;
+      string text = texts[j];
+      boost::replace_all(text, "\n    ", "\n" + indent + "    ");
+      string locals = j == 2 && text.find("(number, ") != string::npos ? indent + "    NUMBERTEXT number;\n" : "";
+      functions += indent + "  " + names[j] + "{\n" + locals + indent + "  " + text.substr(2) + indent + "  }\n";
+    }
+    clog << "Sharing " << shapes[first].typeName << " with";
+    for (size_t i : *group){
+      SHAPE& s = shapes[i];
+      string &readText = s.file >= 0 ? subtrees[s.file].readFunctionText : s.lazy >= 0 ? lazies[s.lazy].readFunctionText : ::readFunctionText;
+      string &writeText = s.file >= 0 ? subtrees[s.file].writeFunctionText : ::writeFunctionText;
+      string object = "    this->" + s.path;
+      if (isShared[0]) boost::replace_first(readText, s.readText, object + ".readJson(" + s.squaredName + ".as<JsonObject>());\n");
+      if (isShared[1]) boost::replace_first(writeText, s.writeText, object + ".writeJson(" + s.squaredName + ".as<JsonObject>());\n");
+      if (isShared[2]) boost::replace_first(valuesFunctionText, s.valuesText, object + ".appendValues(retval, \"" + s.path + "\");\n");
+      shared.push_back(s.path);
+      if (i == first) continue;
+      clog << " " << s.path;
+      string label = boost::to_upper_copy(s.key), ownIndent = s.declaration.substr(0, s.declaration.find_first_not_of(' '));
+      structText.replace(structText.find(s.declaration, firstAt + 1), s.declaration.size(), ownIndent + "typedef " + shapes[first].typeName + " " + label + "; //the same shape\n" + ownIndent + label + " " + s.key + ";\n");
+    }
+    clog << endl;
+    string declaration = shapes[first].declaration;
+    declaration.insert(declaration.rfind(indent + "}"), functions);
+    structText.replace(firstAt, shapes[first].declaration.size(), declaration);
+  }
+}
+
 int runParser(string uncommentedJson){
 
 // Allocate JsonBuffer
@@ -371,6 +3191,14 @@ int runParser(string uncommentedJson){
     return -2;
   }
   
+  if (makeImplementation){
+    implementationOutput.open(implementationFilename);
+    if (!implementationOutput) {
+      cerr << "Failed to open implementation file " << implementationFilename << " for output. Continuing with the functions in the header..." << endl;
+      makeImplementation = false;
+    }
+  }
+
   if (makeSnippetFile){
     snippetOutput.open(snippetFilename);
     if (!snippetOutput) {
@@ -379,6 +3207,7 @@ int runParser(string uncommentedJson){
     }
     else{
       snippetOutput << R"(//void handleSubmitSettings(){)" << endl;
+      snippetOutput << "  " << structureName << ".submit(webServer);" << endl;
     }
   }
 
@@ -492,6 +3321,14 @@ readFunctionText = R"(
 )";
 
 
+  //the settings file is read into memory for the A/B slots and for skipping <LAZY> objects
+  readInMemory = makeSlots;
+  for (auto& idComments : commentsNew){
+    for (const string& comment : idComments.second){
+      if (!makeJournal && comment.find("<LAZY>") != string::npos) readInMemory = true;
+    }
+  }
+
   cout << "// Generated on " << buf << endl << endl;
 	cout << "#pragma once" << endl << endl;
   cout << R"(
@@ -500,33 +3337,76 @@ readFunctionText = R"(
 #include <ArduinoJson.h>
 #include <FS.h>
 #define JSON_BUF_SIZE 3000
-
+)";
+  if (!makeSlots) cout << R"(
 #define OUT(f)\
     File settingsFile = SPIFFS.open(f, "w");\
     root.prettyPrintTo(settingsFile);\
     settingsFile.close();
-    
+    )";
+  if (!readInMemory) cout << R"(
+#ifndef READ_BUF_SIZE
+#define READ_BUF_SIZE 256 //bytes read() takes from the settings file at a time; a SPIFFS page
+#endif
 #define IN(f)\
-    File settingsFile = SPIFFS.open(this->filename, "r");
-
+    BLOCKREADER settingsFile(SPIFFS.open(f, "r"));
+)";
+  cout << R"(
 #else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
 #include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <string>
 #include "ArduinoJson-v5.13.4.h"
 
 #define String string
 #define JSON_BUF_SIZE 3000
-
+)";
+  if (makeOverrides || makeTable) cout << R"(#ifndef PROGMEM
+#define PROGMEM
+#define FPSTR(p) (p)
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strcpy_P strcpy
+)" << (makeTable ? "#define strlen_P strlen\n" : "") << "#endif\n";
+  if (!makeSlots) cout << R"(
 #define OUT(f)\
     string buf;\
     root.prettyPrintTo(buf);\
     ofstream settingsFile(f);\
     settingsFile << buf;\
     settingsFile.close();
-#define IN(f)\
-    ifstream settingsFile;\
-    settingsFile.open(this->filename);
+)";
+  if (!readInMemory) cout << R"(#ifndef READ_BUF_SIZE
+#define READ_BUF_SIZE 4096 //bytes read() takes from the settings file at a time, when it can't be mapped
 #endif
+#define IN(f)\
+    BLOCKREADER settingsFile(String(f).c_str());
+)";
+  cout << "#endif\n";
+  if (readInMemory && !makeSlots) cout << R"(
+#define IN(f)\
+    JSONTEXT settingsFile;\
+    settingsFile.json = (char *)loadBytes(String(f).c_str(), settingsFile.length);
+)";
+  if (makeSlots) cout << R"(
+#define SLOT_HEADER 32 //"J2SA generation length crc32\n", numbers in 8 hex digits
+
+#define OUT(f)\
+    size_t jsonLength = root.measureLength();\
+    char *json = (char *)malloc(SLOT_HEADER + jsonLength + 1);\
+    if (!json) return false;\
+    root.printTo(json + SLOT_HEADER, jsonLength + 1);\
+    bool slotSaved = this->saveSlot(f, json, jsonLength);\
+    free(json);\
+    if (!slotSaved) return false;
+#define IN(f)\
+    JSONTEXT settingsFile;\
+    this->loadSlot(f, settingsFile);
 )";
 
 
@@ -542,13 +3422,51 @@ readFunctionText = R"(
 #define READ_VERSION_NO_MATCH 2
 #define READ_FILE_NOT_FOUND 3
 
+)";
+  if (makeScheduler) cout << R"(#ifndef WRITE_COALESCE_MS
+#define WRITE_COALESCE_MS 2000 //service() writes this long after the first of a burst of requestWrite() calls
+#endif
+#ifndef WRITE_MIN_INTERVAL_MS
+#define WRITE_MIN_INTERVAL_MS 30000 //and no sooner than this after its previous write
+#endif
+
+)";
+  if (makeJournal) cout << R"(#ifndef JOURNAL_COMPACT_BYTES
+#define JOURNAL_COMPACT_BYTES 1024 //writeDirty() compacts the journal into the settings file once it grows past this
+#endif
+
+)";
+  if (makeBinary) cout << R"(#define BIN_WRITE_BOTH 0 //write() updates the json and the binary files
+#define BIN_WRITE_ONLY 1 //write() updates the binary file only
+#ifndef BIN_WRITE_POLICY
+#define BIN_WRITE_POLICY BIN_WRITE_BOTH
+#endif
+
 )";
 	cout << "using namespace std;" << endl << endl;
   // cout << "struct SETTINGS {" << endl;
+  ostringstream structText;
+  iterateObject(root, structText, 0); //write .h and html form
+  string sharedStructText = structText.str();
+  shareShapes(sharedStructText);
+  if (makeTable){ //the fields of the table are read and written by its interpreter
+    boost::replace_all(::readFunctionText, "    if (this->version != root[\"version\"].as<char*>()) return READ_VERSION_NO_MATCH;\n", "    if (this->version != root[\"version\"].as<char*>()) return READ_VERSION_NO_MATCH;\n    this->readTable(root);\n");
+  }
+  for (const FIELD& f : fields){ //a <CONST> version is checked against the literal
+    if (f.path == "version" && f.isConst) boost::replace_all(readFunctionText, R"(if (this->version != root["version"].as<char*>()))", R"(if (strcmp(this->version, root["version"] | "")))");
+  }
+  string implementationText; //-c option: the definitions the header only declares
+  string defaultsTableText = makeOverrides ? makeDefaultsTableText() : "";
+  if (makeImplementation && makeOverrides){ //the defaults are only used by the functions moved
+    size_t table = defaultsTableText.find("static const ");
+    implementationText += defaultsTableText.substr(table) + "\n";
+    defaultsTableText.erase(table);
+  }
+  cout << defaultsTableText;
+  ostringstream structOutput; //-c option: the struct, for its function bodies to be moved
+  streambuf *coutBuffer = makeImplementation ? cout.rdbuf(structOutput.rdbuf()) : nullptr;
   cout << "struct " << structureLabel << "{" << endl;
-
-
-  iterateObject(root, cout, 0); //write .h and html form
+  cout << sharedStructText;
   // clog << "initValues:" << endl << initValues <<endl << "END initValues" << endl;
 
 	// writeFunctionText += R"(
@@ -556,6 +3474,8 @@ readFunctionText = R"(
   //   root.prettyPrintTo(settingsFile);
   //   return true;
   // )";
+  if (makeTable) writeFunctionText += "    this->writeTable(root);\n";
+	writeFunctionText += pruneFunctionText;
 	writeFunctionText += R"(
     OUT(this->filename);
     return true;
@@ -568,24 +3488,163 @@ readFunctionText = R"(
   )";
   readFunctionText += R"(}//read)";
   
+  if (readInMemory){
+    //IN() loads the settings file (or its newest valid slot) into memory; parse it there
+    boost::replace_first(readFunctionText, "jb.parseObject(settingsFile)", "jb.parseObject(settingsFile.json)");
+  }
+  else boost::replace_first(readFunctionText, "jb.parseObject(settingsFile)", "settingsFile.parseObject(jb)"); //through its buffer, see BLOCKREADER
+
+  if (!lazies.empty()){
+    //note where the lazy objects are and keep them from the parser; they are loaded on first use
+    string count = to_string(lazies.size());
+    boost::replace_first(readFunctionText, "    JsonObject &root = jb.parseObject(", "    LAZYRANGE lazyRanges[" + count + "];\n    skipLazy(settingsFile.json, lazyRanges);\n    JsonObject &root = jb.parseObject(");
+    boost::replace_last(readFunctionText, "    return READ_OK;", "    memcpy(this->lazyRanges, lazyRanges, sizeof lazyRanges);\n    return READ_OK;");
+    boost::replace_first(writeFunctionText, "    DynamicJsonBuffer jb(JSON_BUF_SIZE);\n", "    if (!this->loadLazy()) return false; //everything is about to be written, not the defaults of what couldn't be loaded\n    DynamicJsonBuffer jb(JSON_BUF_SIZE);\n");
+  }
+
+  if (makeBinary){
+    //binary after the json file, whose crc it keeps; a power cut between them leaves a binary file that read() turns down
+    boost::replace_first(writeFunctionText, "  bool write() {\n", R"(  bool write() {
+#if BIN_WRITE_POLICY == BIN_WRITE_ONLY
+    if (!this->writeBinary()) return false;
+    return true;
+#endif
+)");
+    boost::replace_first(writeFunctionText, "    OUT(this->filename);\n", "    OUT(this->filename);\n    if (!this->writeBinary()) return false;\n");
+    boost::replace_first(readFunctionText, "  int read() {\n", R"(  int read() {
+    if (this->readBinary() == READ_OK){
+      return READ_OK;
+    }
+)");
+    //fall back to json, then make the binary file so the next read() is quick
+    boost::replace_last(readFunctionText, "    return READ_OK;", R"(    this->writeBinary();
+    return READ_OK;)");
+  }
+
+  if (!lazies.empty()){
+    //ranges noted in a file read before are no use, even if this read() fails
+    boost::replace_first(readFunctionText, "  int read() {\n", "  int read() {\n    memset(this->lazyRanges, 0, sizeof this->lazyRanges);\n");
+  }
+
+  if (makeJournal){
+    //the full write compacts the journal; writeDirty() appends to it
+    boost::replace_first(writeFunctionText, "  bool write() {\n", R"(  bool write() {
+    if ((this->journalBytes == (size_t)-1 || (this->journalBytes && !this->appendJournal(true))) && !removeFile(journalFilename().c_str())) return false;
+)");
+    writeFunctionText = regex_replace(writeFunctionText, regex("( *)return true;"), R"($1if (!removeFile(journalFilename().c_str())) return false;
+$1this->journalBytes = 0;
+$&)");
+    readFunctionText = regex_replace(readFunctionText, regex("( *)return READ_OK;"), "$1this->replayJournal();\n$&");
+    if (!makeSlots){ //the settings file is replaced whole, never left half written beside the journal
+      boost::replace_first(writeFunctionText, "    OUT(this->filename);\n", R"(    String json;
+    root.prettyPrintTo(json);
+    if (!saveBytes(this->filename, (const uint8_t *)json.c_str(), json.length())) return false;
+)");
+      boost::replace_first(readFunctionText, "    IN(this->filename);\n", "    recoverFile(this->filename);\n    IN(this->filename);\n");
+    }
+    //without a settings file to build on, the journal will do if it holds every field, as after a write() that was cut short
+    for (const char *failure : {"if (!settingsFile) return READ_FILE_NOT_FOUND;", "if (!root.success()) return READ_PARSE_FAIL;"}){
+      string test = failure;
+      string code = test.substr(test.find("return "));
+      test = test.substr(0, test.find(" return "));
+      boost::replace_first(readFunctionText, "    " + string(failure) + "\n", "    " + test + "{\n      if (!this->replayJournal()){\n        this->journalBytes = (size_t)-1; //writeDirty() writes the whole file\n        " + code + "\n      }\n      return READ_OK;\n    }\n");
+    }
+  }
+
+  if (trackDirty){
+    //whatever was just written or read is clean
+    writeFunctionText = regex_replace(writeFunctionText, regex("( *)return true;"), clearDirtyText(-1, "$1") + "$&");
+    readFunctionText = regex_replace(readFunctionText, regex("( *)return READ_OK;"), clearDirtyText(-1, "$1") + "$&");
+  }
+
+  if (makeScheduler){
+    //the scheduler's minimum interval counts every write, however it was made
+    writeFunctionText = regex_replace(writeFunctionText, regex("( *)return true;"), "$1this->writeUntimed = true;\n$&");
+  }
+
+  string journalFunctionText = makeJournal ? makeJournalFunctionText() : "";
+  if (!subtrees.empty()){
+    //read() and write() cover all the files; the main settings file gets functions of its own
+    boost::replace_first(writeFunctionText, "  bool write() {", "  bool writeSettingsFile() {");
+    boost::replace_first(writeFunctionText, "}//write", "}//writeSettingsFile");
+    boost::replace_first(journalFunctionText, "  bool writeDirty() {", "  bool writeDirtySettingsFile() {");
+    boost::replace_first(journalFunctionText, "}//writeDirty", "}//writeDirtySettingsFile");
+    boost::replace_all(journalFunctionText, "this->write()", "this->writeSettingsFile()");
+    boost::replace_first(readFunctionText, "  int read() {", "  int readSettingsFile() {");
+    boost::replace_last(readFunctionText, "}//read", "}//readSettingsFile");
+    if (trackDirty) boost::replace_first(journalFunctionText, "    this->clearDirty();\n", clearDirtyText(-1));
+  }
+
   cout << writeFunctionText << endl;
   cout << readFunctionText << endl;
-
-  cout << "  String getValuesScript(){\n";
+  if (hasTextBuffers()) cout << makeTextHelpersText() << endl;
+  if (hasNarrowIntegers()) cout << makeIntegerHelpersText() << endl;
+  if (hasDecimals()) cout << makeDecimalHelpersText() << endl;
+  if (hasIpv4s()) cout << makeIpv4HelpersText() << endl;
+  if (hasEnums()) cout << makeEnumHelpersText() << endl;
+  if (hasNumbers()) cout << makeNumberHelpersText() << endl;
+  cout << makeVisitorText() << endl;
+  cout << makeFingerprintHelpersText() << comparisonFunctionText << endl;
+  if (makeTable) cout << makeTableFunctionText() << endl;
+  if (!subtrees.empty()) cout << makeSubtreeFunctionText() << makeComposedFunctionText() << endl;
+  if (makeBinary || makeJournal || readInMemory) cout << makeBinaryHelpersText() << endl;
+  if (readInMemory) cout << makeJsonTextStructText() << endl;
+  else cout << makeBlockReaderText() << endl;
+  if (makeSlots) cout << makeSlotFunctionText() << endl;
+  if (!lazies.empty()) cout << makeLazyFunctionText() << endl;
+  if (!lazies.empty() || !eagerLazies.empty()) cout << makeLazyAccessorText() << endl;
+  if (makeBinary) cout << makeBinaryFunctionText() << endl;
+  if (makeJournal) cout << journalFunctionText << endl;
+  if (trackDirty) cout << makeDirtyFunctionText() << endl;
+  if (makeScheduler) cout << makeSchedulerFunctionText() << endl;
+  if (makeOverrides) cout << makeDefaultsFunctionText() << endl;
+  else if (!bitfieldDefaultsText.empty()) cout << "  " << structureLabel << "(){ //bitfields can't be given their defaults where they are declared\n" << bitfieldDefaultsText << "  }\n" << endl;
+
+  cout << (cacheValuesScript ? "  String makeValuesScript(){\n" : "  String getValuesScript(){\n");
+  if (!lazies.empty() && !cacheValuesScript) cout << "    this->loadLazy();\n";
   cout << R"(    String retval = "";)" << endl;
+  if (valuesFunctionText.find("(number, ") != string::npos) cout << "    NUMBERTEXT number;\n";
   
   cout << R"(    retval += String("var values = {};") + "\n";)" << endl; //HERE
 
-  cout << valuesFunctionText << endl;
+  cout << valuesFunctionText;
+  if (makeTable) cout << "    this->valuesTable(retval);\n";
+  cout << endl;
 
   cout << R"(    retval += "for (var key in values) {";)" << endl;
   cout << R"(    retval += "  document.getElementById(key).value = values[key];";)"  << endl;
   cout << R"(    retval += "}";)" << endl;
 
   cout << "    return retval;" << endl;
-  cout << "  }//getValuesScript\n" << endl;
-
-  cout << "} " << structureName << ";" << endl;
+  cout << (cacheValuesScript ? "  }//makeValuesScript\n" : "  }//getValuesScript\n") << endl;
+  if (cacheValuesScript) cout << makeValuesCacheText() << endl;
+
+  if (makeSnippetFile) cout << (makeTable ? makeTableSubmitFunctionText() : makeSubmitFunctionText()) << endl;
+
+  if (makeImplementation){
+    string functionsText;
+    cout.rdbuf(coutBuffer);
+    cout << moveFunctionBodies(structOutput.str(), functionsText);
+    cout << "};\n" << "extern " << structureLabel << " " << structureName << ";" << endl;
+    if (hasConsts()) implementationText = makeConstDefinitionsText() + "\n" + implementationText;
+    if (makeTable) implementationText = makeFieldTableText() + "\n" + implementationText;
+    implementationOutput << "// Generated on " << buf << endl << endl;
+    implementationOutput << "#ifdef ARDUINO\n#include <Arduino.h>\n#endif\n";
+    string header = implementationFilename;
+    header = header.substr(header.find_last_of('/') + 1);
+    header = header.substr(0, header.rfind('.')) + ".h";
+    implementationOutput << "#include \"" << header << "\"" << endl << endl;
+    implementationOutput << implementationText << functionsText;
+    implementationOutput << structureLabel << " " << structureName << ";" << endl;
+    implementationOutput.close();
+  }
+  else{
+    cout << "} " << structureName << ";" << endl;
+    if (hasConsts()) cout << makeConstDefinitionsText() << endl;
+    if (makeTable) cout << makeFieldTableText();
+  }
+  if (makeTable) cout << makeTableReportText() << endl;
+  if (makeLayout) cout << makeLayoutReportText() << endl;
 
   if (makeValuesJsFile){
     valuesJs << initValues << endl;
@@ -644,12 +3703,69 @@ int main(int argc, char *argv[]){
       htmlFormFilename = argv[i + 1];
       continue;
     }
+    if ( !strcmp(argv[i], "-c") && (i + 1 < argc) ){
+      clog << "Writing the member functions to " << argv[i + 1] << endl;
+      makeImplementation = true;
+      implementationFilename = argv[i + 1];
+      continue;
+    }
+    if ( !strcmp(argv[i], "-j") ){
+      clog << "Will add a settings journal (and setters) to the header file." << endl;
+      makeJournal = true;
+      trackDirty = true;
+      continue;
+    }
     if ( !strcmp(argv[i], "-s") && (i + 1 < argc) ){
       clog << "Writing snippet code to " << argv[i + 1] << endl;
       makeSnippetFile = true;
       snippetFilename = argv[i + 1];
       continue;
     }
+    if ( !strcmp(argv[i], "-m") ){
+      clog << "Will keep the values script and make it again only when a field on the form changes." << endl;
+      cacheValuesScript = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-w") ){
+      clog << "Will add a deferred write scheduler to the header file." << endl;
+      makeScheduler = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-g") ){
+      clog << "Will read, write and submit the settings through a table of the fields." << endl;
+      makeTable = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-i") ){
+      clog << "Will give untagged integers the narrowest type that holds their defaults." << endl;
+      inferIntegers = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-l") ){
+      clog << "Will declare the struct members most aligned first and pack the bools into bitfields." << endl;
+      makeLayout = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-o") ){
+      clog << "Will keep the defaults in flash and write only the settings that differ from them." << endl;
+      makeOverrides = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-a") ){
+      clog << "Will keep the settings file in two (A/B) slots." << endl;
+      makeSlots = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-b") ){
+      clog << "Will add a packed binary settings file to the header file." << endl;
+      makeBinary = true;
+      continue;
+    }
+    if ( !strcmp(argv[i], "-d") ){
+      clog << "Will add setters and dirty tracking to the header file." << endl;
+      trackDirty = true;
+      continue;
+    }
     if ( !strcmp(argv[i], "-t") ){
       clog << "Will transfer comments to header file." << endl;
       transferComments = true;
@@ -663,6 +3779,11 @@ int main(int argc, char *argv[]){
     }
 }
 
+    if (makeTable && makeOverrides){
+      clog << "Ignoring -g: the sparse write of -o compares each field with its own default." << endl;
+      makeTable = false;
+    }
+
     string line;
     string uncommentedJson;  //will contain an uncommented version of json for ArduinoJson
     while (getline(cin, line))
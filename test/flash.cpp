@@ -0,0 +1,20 @@
+/**
+ * What -g is meant to shrink - read(), write(), getValuesScript() and submit() - for "make flash-report", which compiles it
+ * against headers made with and without -g and gives the sizes of the two objects side by side.
+ */
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include "settings.h"
+
+struct SERVER { //the part of ESP8266WebServer that submit() uses
+  String name, value;
+  int args(){ return 1; }
+  const String &argName(int){ return this->name; }
+  const String &arg(int){ return this->value; }
+};
+
+bool useSettings(SERVER &server){
+  settings.submit(server);
+  return settings.read() == READ_OK && settings.write() && settings.getValuesScript().length();
+}
@@ -0,0 +1,162 @@
+/**
+ * Host test of the settings journal (-j option), run by "make test" in a scratch directory:
+ * the journal and the settings file are cut short at every offset, as a power cut could leave them,
+ * and read() must give back the settings of the last record or write() that was whole.
+ * Also times read() with and without a journal to replay.
+ */
+#include "journal.h"
+#include <chrono>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition, ...)\
+    if (!(condition)){\
+      printf("%s:%d: %s: ", __FILE__, __LINE__, #condition);\
+      printf(__VA_ARGS__);\
+      printf("\n");\
+      failures++;\
+    }
+
+static string load(const string &f){
+  ifstream file(f, ios::binary);
+  return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+static void save(const string &f, const string &text){
+  ofstream file(f, ios::binary | ios::trunc);
+  file << text;
+}
+
+static const string settingsFile = SETTINGS::filename;
+static const string journalFile = settingsFile + ".jnl";
+static const string tempFile = settingsFile + ".tmp";
+
+static void clean(){
+  remove(settingsFile.c_str());
+  remove(journalFile.c_str());
+  remove(tempFile.c_str());
+}
+
+static void change(SETTINGS &s, int i){ //one field a call, so each writeDirty() appends one record
+  switch (i % 4){
+    case 0: s.setName(String("journal ") + to_string(i)); break;
+    case 1: s.setCount(i); break;
+    case 2: s.setRatio(i / 4.0); break;
+    case 3: s.setNetworkSsid(("ssid " + to_string(i)).c_str()); break;
+  }
+}
+
+int main(){
+  clean();
+
+  //a field changed without its setter is still saved by write()
+  SETTINGS s;
+  s.count = 5;
+  CHECK(s.write(), "write() failed");
+  SETTINGS r;
+  CHECK(r.read() == READ_OK && r.count == 5, "count %ld", r.count);
+
+  //a journal of one record per writeDirty()
+  vector<SETTINGS> states = {s};
+  vector<size_t> sizes = {0}; //of the journal after each writeDirty()
+  for (int i = 1; i <= 12; i++){
+    change(s, i);
+    CHECK(s.writeDirty() && s.journalBytes, "writeDirty() %d compacted or failed", i);
+    states.push_back(s);
+    sizes.push_back(load(journalFile).size());
+  }
+  const string base = load(settingsFile), journal = load(journalFile);
+
+  //the journal cut short: the records that are whole are replayed, the torn one is dropped
+  for (size_t offset = 0; offset <= journal.size(); offset++){
+    save(settingsFile, base);
+    save(journalFile, journal.substr(0, offset));
+    size_t k = 0;
+    while (k + 1 < sizes.size() && sizes[k + 1] <= offset) k++;
+    SETTINGS r;
+    int result = r.read();
+    CHECK(result == READ_OK, "journal cut at %zu: read() %d", offset, result);
+    CHECK(r == states[k], "journal cut at %zu: not the settings of record %zu", offset, k);
+    //and the next writeDirty() leaves a journal that can be appended to
+    r.setCount(1000 + offset);
+    SETTINGS after;
+    CHECK(r.writeDirty() && after.read() == READ_OK && after == r, "journal cut at %zu: writeDirty() lost", offset);
+  }
+
+  //write() cut short while compacting: it has appended a record of every field to the journal, then replaces the settings file
+  save(settingsFile, base);
+  save(journalFile, journal);
+  SETTINGS c;
+  CHECK(c.read() == READ_OK && c == states.back(), "journal not replayed");
+  c.count = 12345; //without the setter
+  c.setName("compacted");
+  CHECK(c.appendJournal(true), "appendJournal() failed");
+  const string snapshot = load(journalFile);
+  const string compacted = [&c](){ SETTINGS w = c; w.write(); return load(settingsFile); }();
+  for (size_t offset = 0; offset <= compacted.size(); offset++){
+    //the replacement cut short: the old settings file is still there
+    save(settingsFile, base);
+    save(journalFile, snapshot);
+    save(tempFile, compacted.substr(0, offset));
+    SETTINGS r;
+    int result = r.read();
+    CHECK(result == READ_OK && r == c, "replacement cut at %zu: read() %d", offset, result);
+    remove(tempFile.c_str());
+
+    //the settings file half written, as writing it in place would leave it
+    save(settingsFile, compacted.substr(0, offset));
+    save(journalFile, snapshot);
+    SETTINGS h;
+    result = h.read();
+    CHECK(result == READ_OK && h == c, "settings file cut at %zu: read() %d", offset, result);
+
+    //and without the record of every field there is nothing to fall back on
+    if (offset == compacted.size()) continue;
+    save(settingsFile, compacted.substr(0, offset));
+    save(journalFile, journal);
+    SETTINGS f;
+    result = f.read();
+    CHECK(result == READ_PARSE_FAIL, "settings file cut at %zu, old journal: read() %d", offset, result);
+  }
+
+  //removed, with the replacement not yet renamed (SPIFFS can't rename over a file)
+  remove(settingsFile.c_str());
+  save(journalFile, snapshot);
+  SETTINGS m;
+  CHECK(m.read() == READ_OK && m == c, "settings file missing: journal not replayed");
+
+  //neither: the next writeDirty() writes the whole file
+  clean();
+  SETTINGS n;
+  CHECK(n.read() == READ_FILE_NOT_FOUND, "read() of nothing");
+  n.setCount(7);
+  SETTINGS w;
+  CHECK(n.writeDirty() && w.read() == READ_OK && w == n, "writeDirty() without a settings file");
+
+  //replay time: a journal about to be compacted against none
+  clean();
+  SETTINGS t;
+  t.write();
+  for (int i = 0; t.journalBytes + 16 <= JOURNAL_COMPACT_BYTES; i++){
+    t.setCount(i);
+    t.writeDirty();
+  }
+  size_t journalBytes = t.journalBytes;
+  const int runs = 1000;
+  double us[2];
+  for (int j = 0; j < 2; j++){
+    if (j) t.write();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++){
+      SETTINGS r;
+      r.read();
+    }
+    us[j] = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / runs;
+  }
+  printf("read(): %.1f us with a %zu byte journal, %.1f us without\n", us[0], journalBytes, us[1]);
+
+  clean();
+  printf("%s: %d failures\n", failures ? "FAILED" : "passed", failures);
+  return failures != 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * Host benchmark of formatLong() and formatDouble(), which getValuesScript() formats numbers with, against snprintf and
+ * to_string (the host's String(n)), run by "make bench". Each formatDouble() text is checked to read back as the same double.
+ */
+#include "settings.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+static size_t sink; //keeps the results from being optimised away
+
+template <class F> static double nsPerCall(const char *name, size_t n, F format){
+  const int rounds = 20;
+  auto start = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) for (size_t i = 0; i < n; i++) sink += format(i);
+  double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / rounds / n;
+  printf("  %-22s %7.1f ns\n", name, ns);
+  return ns;
+}
+
+int main(){
+  const size_t n = 100000;
+  vector<long> longs(n);
+  vector<double> decimals(n), doubles(n);
+  for (size_t i = 0; i < n; i++){
+    longs[i] = (long)(i * 7919 % 2000003) - 1000000;
+    decimals[i] = longs[i] / 100.0; //up to 2 places, as most settings have
+    doubles[i] = 1.0 / (i + 3); //all 17 digits
+  }
+  SETTINGS::NUMBERTEXT text;
+  char buf[32];
+
+  int mismatches = 0;
+  for (const vector<double>* values : {&decimals, &doubles}){
+    for (double d : *values) if (strtod(SETTINGS::formatDouble(text, d), nullptr) != d) mismatches++;
+  }
+  for (long l : longs){
+    snprintf(buf, sizeof buf, "%ld", l);
+    if (strcmp(SETTINGS::formatLong(text, l), buf)) mismatches++;
+  }
+
+  printf("longs:\n");
+  double format = nsPerCall("formatLong", n, [&](size_t i){ return strlen(SETTINGS::formatLong(text, longs[i])); });
+  double print = nsPerCall("snprintf(\"%ld\")", n, [&](size_t i){ return (size_t)snprintf(buf, sizeof buf, "%ld", longs[i]); });
+  nsPerCall("to_string", n, [&](size_t i){ return to_string(longs[i]).size(); });
+  printf("  formatLong takes %.2f of the time of snprintf\n", format / print);
+
+  for (const vector<double>* values : {&decimals, &doubles}){
+    printf(values == &decimals ? "doubles of 2 places:\n" : "doubles of 17 digits:\n");
+    format = nsPerCall("formatDouble", n, [&](size_t i){ return strlen(SETTINGS::formatDouble(text, (*values)[i])); });
+    print = nsPerCall("snprintf(\"%.17g\")", n, [&](size_t i){ return (size_t)snprintf(buf, sizeof buf, "%.17g", (*values)[i]); });
+    nsPerCall("to_string", n, [&](size_t i){ return to_string((*values)[i]).size(); });
+    printf("  formatDouble takes %.2f of the time of snprintf\n", format / print);
+  }
+
+  printf("%s: %d texts that don't read back (%zu)\n", mismatches ? "FAILED" : "passed", mismatches, sink % 10);
+  return mismatches != 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * Host benchmark of parsing the settings file through a BLOCKREADER, as read() does, against parsing it from an ifstream,
+ * as read() did before, run by "make bench" in a scratch directory. The file is padded out to each size with a long name;
+ * files that fill their last page can't be mapped, so those are read in READ_BUF_SIZE blocks instead.
+ */
+#include "read.h"
+#include <chrono>
+
+static size_t sink; //keeps the results from being optimised away
+
+template <class F> static double usPerCall(F parse){
+  const int rounds = 200;
+  auto start = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) sink += parse();
+  return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+}
+
+static size_t fileSize(const char *f){
+  ifstream file(f, ios::binary | ios::ate);
+  return file.tellg();
+}
+
+int main(){
+  const size_t page = sysconf(_SC_PAGESIZE);
+  int mismatches = 0;
+  SETTINGS s;
+  for (size_t target : {2000, 20000, 200000, 20 * 4096}){
+    s.name = "";
+    s.write();
+    s.name = String(target - fileSize(s.filename), 'x'); //a name of n characters makes the file n bytes longer
+    s.write();
+    size_t size = fileSize(s.filename);
+    bool mapped = size % page != 0;
+
+    size_t viaStream = 0, viaBlocks = 0;
+    double stream = usPerCall([&](){
+      ifstream file(s.filename);
+      DynamicJsonBuffer jb(JSON_BUF_SIZE);
+      JsonObject &root = jb.parseObject(file);
+      return viaStream = strlen(root["name"] | "");
+    });
+    double blocks = usPerCall([&](){
+      SETTINGS::BLOCKREADER file(s.filename);
+      DynamicJsonBuffer jb(JSON_BUF_SIZE);
+      JsonObject &root = file.parseObject(jb);
+      return viaBlocks = strlen(root["name"] | "");
+    });
+    double read = usPerCall([&](){
+      SETTINGS r;
+      return (size_t)r.read();
+    });
+    if (viaStream != s.name.length() || viaBlocks != s.name.length()) mismatches++;
+    printf("%6zu bytes, %s: ifstream %7.1f us, BLOCKREADER %7.1f us (%.2f of the time), read() %7.1f us\n",
+        size, mapped ? "mapped" : "blocks", stream, blocks, blocks / stream, read);
+  }
+  remove(s.filename);
+
+  printf("%s: %d sizes parsed differently (%zu)\n", mismatches ? "FAILED" : "passed", mismatches, sink % 10);
+  return mismatches != 0;
+}